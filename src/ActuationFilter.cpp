@@ -0,0 +1,128 @@
+#include "ActuationFilter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace temper {
+
+static double envSeconds(const char* name) {
+    const char* env = std::getenv(name);
+    return env ? std::max(0.0, std::atof(env)) : 0.0;
+}
+
+ActuationFilter::ActuationFilter() {
+    smoothingSec_ = envSeconds("TEMP_SMOOTHING_SEC");
+    riseC_ = envSeconds("HYSTERESIS_RISE_C");
+    fallC_ = envSeconds("HYSTERESIS_FALL_C");
+    fanSlew_ = envSeconds("FAN_SLEW_PCT_PER_SEC");
+    powerSlew_ = envSeconds("POWER_SLEW_W_PER_SEC");
+    throttleConfirmSec_ = envSeconds("THROTTLE_CONFIRM_SEC");
+}
+
+ActuationFilter::Device& ActuationFilter::device(unsigned int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_[index];
+}
+
+double ActuationFilter::smoothTemperature(unsigned int device, double temp) {
+    Device& d = this->device(device);
+    auto now = Clock::now();
+    if (!d.haveTemp || smoothingSec_ <= 0.0) {
+        d.haveTemp = true;
+        d.temp = temp;
+    } else {
+        // Weight from the real interval, so a late tick counts for what it covers
+        double dt = std::chrono::duration<double>(now - d.tempAt).count();
+        d.temp += (1.0 - std::exp(-dt / smoothingSec_)) * (temp - d.temp);
+    }
+    d.tempAt = now;
+    return d.temp;
+}
+
+unsigned int ActuationFilter::filter(Channel& c, unsigned int target, unsigned int raw, double temp, bool hysteresis,
+                                     double slewPerSec, unsigned long long& changes, unsigned long long& rawChanges) {
+    auto now = Clock::now();
+    if (!c.started) {
+        c.started = true;
+        c.goal = c.output = target;
+        c.anchorTemp = temp;
+        c.lastRaw = raw;
+        c.lastOut = target;
+        c.last = now;
+        return target;
+    }
+    double dt = std::chrono::duration<double>(now - c.last).count();
+    c.last = now;
+
+    if (raw != c.lastRaw) rawChanges++;
+    c.lastRaw = raw;
+
+    if (target != c.goal) {
+        bool moved = !hysteresis || temp >= c.anchorTemp + riseC_ || temp <= c.anchorTemp - fallC_;
+        if (moved) {
+            c.goal = target;
+            c.anchorTemp = temp;
+        }
+    }
+
+    if (slewPerSec > 0.0) {
+        double step = slewPerSec * dt;
+        c.output = std::clamp(c.goal, c.output - step, c.output + step);
+    } else {
+        c.output = c.goal;
+    }
+
+    unsigned int out = (unsigned int)std::lround(c.output);
+    if (out != c.lastOut) changes++;
+    c.lastOut = out;
+    return out;
+}
+
+unsigned int ActuationFilter::filterFan(unsigned int device, unsigned int fan, unsigned int target, unsigned int raw,
+                                        double temp, bool closedLoop) {
+    Device& d = this->device(device);
+    return filter(d.channels[fan], target, raw, temp, !closedLoop, fanSlew_, d.stats.fanChanges, d.stats.fanChangesRaw);
+}
+
+unsigned int ActuationFilter::filterPower(unsigned int device, unsigned int targetW, unsigned int rawW, double temp) {
+    Device& d = this->device(device);
+    return filter(d.channels[POWER_CHANNEL], targetW, rawW, temp, true, powerSlew_, d.stats.powerChanges, d.stats.powerChangesRaw);
+}
+
+void ActuationFilter::forcePower(unsigned int device, unsigned int watts) {
+    Device& d = this->device(device);
+    Channel& c = d.channels[POWER_CHANNEL];
+    if (c.started && c.lastOut != watts) {
+        d.stats.powerChanges++;
+        d.stats.powerChangesRaw++;
+    }
+    c.started = true;
+    c.goal = c.output = watts;
+    c.lastOut = c.lastRaw = watts;
+    c.last = Clock::now();
+}
+
+bool ActuationFilter::confirmThrottle(unsigned int device, bool throttling) {
+    Device& d = this->device(device);
+    auto now = Clock::now();
+    if (!throttling) {
+        if (d.throttling && now - d.throttleSince < std::chrono::duration<double>(throttleConfirmSec_)) {
+            d.stats.throttleBlipsIgnored++;
+        }
+        d.throttling = false;
+        return false;
+    }
+    if (!d.throttling) {
+        d.throttling = true;
+        d.throttleSince = now;
+    }
+    return now - d.throttleSince >= std::chrono::duration<double>(throttleConfirmSec_);
+}
+
+SmoothingStats ActuationFilter::getStats(unsigned int device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    return it == devices_.end() ? SmoothingStats() : it->second.stats;
+}
+
+} // namespace temper
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace temper {
+
+struct SmoothingStats {
+    unsigned long long fanChanges = 0;       // Target changes sent on (all fans)
+    unsigned long long fanChangesRaw = 0;    // Changes the unfiltered target would have made
+    unsigned long long powerChanges = 0;
+    unsigned long long powerChangesRaw = 0;
+    unsigned long long throttleBlipsIgnored = 0; // Thermal throttle samples that cleared before confirmation
+};
+
+// Calms targets between the curves and the Actuator.
+//
+// The curve input is an EMA of the temperature. A new target is only taken
+// once the temperature has moved HYSTERESIS_RISE_C above or HYSTERESIS_FALL_C
+// below where the target last changed. The output then moves toward it no
+// faster than the slew limit. The power path's thermal fallback must see
+// the throttle bit for THROTTLE_CONFIRM_SEC before it fires. All time
+// constants use measured tick time, and every stage is off by default.
+//
+// Configuration (environment):
+//   TEMP_SMOOTHING_SEC    EMA time constant for curve inputs (default 0: off)
+//   HYSTERESIS_RISE_C     Rise needed before retargeting (default 0)
+//   HYSTERESIS_FALL_C     Fall needed before retargeting (default 0)
+//   FAN_SLEW_PCT_PER_SEC  Max fan change per second (default 0: unlimited)
+//   POWER_SLEW_W_PER_SEC  Max power limit change per second (default 0: unlimited)
+//   THROTTLE_CONFIRM_SEC  Throttle persistence before the minimum-power fallback (default 0)
+class ActuationFilter {
+public:
+    ActuationFilter();
+
+    double smoothTemperature(unsigned int device, double temp);
+    // raw: the target without smoothing; only counted. closedLoop skips hysteresis (PID output moves on its own)
+    unsigned int filterFan(unsigned int device, unsigned int fan, unsigned int target, unsigned int raw, double temp, bool closedLoop);
+    unsigned int filterPower(unsigned int device, unsigned int targetW, unsigned int rawW, double temp);
+    // Fallback taken: the limit jumps to minW at once, and later slews up from there
+    void forcePower(unsigned int device, unsigned int watts);
+    bool confirmThrottle(unsigned int device, bool throttling);
+
+    SmoothingStats getStats(unsigned int device) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Channel {
+        bool started = false;
+        double goal = 0.0;     // Accepted target
+        double output = 0.0;   // Slewed toward goal
+        double anchorTemp = 0.0;
+        unsigned int lastRaw = 0;
+        unsigned int lastOut = 0;
+        Clock::time_point last;
+    };
+
+    struct Device {
+        bool haveTemp = false;
+        double temp = 0.0;
+        Clock::time_point tempAt;
+        bool throttling = false;
+        Clock::time_point throttleSince;
+        std::map<unsigned int, Channel> channels; // Fan index, or POWER_CHANNEL
+        SmoothingStats stats;
+    };
+
+    static constexpr unsigned int POWER_CHANNEL = ~0u;
+
+    Device& device(unsigned int index);
+    unsigned int filter(Channel& c, unsigned int target, unsigned int raw, double temp, bool hysteresis, double slewPerSec,
+                        unsigned long long& changes, unsigned long long& rawChanges);
+
+    double smoothingSec_ = 0.0;
+    double riseC_ = 0.0;
+    double fallC_ = 0.0;
+    double fanSlew_ = 0.0;
+    double powerSlew_ = 0.0;
+    double throttleConfirmSec_ = 0.0;
+
+    mutable std::mutex mutex_; // Guards the map only; each entry belongs to one device's poller
+    std::map<unsigned int, Device> devices_;
+};
+
+} // namespace temper
@@ -0,0 +1,231 @@
+#include "Actuator.hpp"
+#include <cstdlib>
+#include <iostream>
+
+namespace temper {
+
+Actuator::Actuator(GpuBackend& backend) : backend_(backend) {
+    const char* fEnv = std::getenv("FAN_DEADBAND");
+    if (fEnv) fanDeadband_ = std::strtoul(fEnv, nullptr, 10);
+
+    const char* pEnv = std::getenv("POWER_DEADBAND_W");
+    if (pEnv) powerDeadband_ = std::strtoul(pEnv, nullptr, 10);
+
+    const char* cEnv = std::getenv("CLOCK_DEADBAND_MHZ");
+    if (cEnv) clockDeadband_ = std::strtoul(cEnv, nullptr, 10);
+
+    const char* rEnv = std::getenv("ACTUATION_REASSERT_SEC");
+    if (rEnv) reassertInterval_ = std::chrono::seconds(std::strtoul(rEnv, nullptr, 10));
+}
+
+void Actuator::addDevice(nvmlDevice_t handle) {
+    unsigned int fans = backend_.getNumFans(handle);
+    unsigned int minW = 0, maxW = 0;
+    try {
+        backend_.getPowerConstraints(handle, minW, maxW);
+    } catch (const std::exception& e) {
+        std::cerr << "[Actuator] Power limit control unavailable: " << e.what() << std::endl;
+    }
+    GpuBackend::Clocks clocks;
+    try {
+        clocks = backend_.getClocks(handle);
+    } catch (const std::exception&) {
+        // Unknown maxima: targets go to the driver unclamped
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Device& d = devices_.emplace_back();
+    d.handle = handle;
+    d.fans.resize(fans);
+    d.minW = minW;
+    d.maxW = maxW;
+    d.powerSupported = maxW > 0;
+    d.maxGraphicsMHz = clocks.maxGraphics;
+    d.maxMemoryMHz = clocks.maxMemory;
+}
+
+Actuator::Device& Actuator::device(unsigned int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_.at(index);
+}
+
+const Actuator::Device& Actuator::device(unsigned int index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_.at(index);
+}
+
+bool Actuator::shouldWrite(const Setting& s, unsigned int target, unsigned int deadband, Clock::time_point now) const {
+    if (now < s.retryAt) return false;
+    if (s.applied < 0) return true;
+    unsigned int delta = target > (unsigned int)s.applied ? target - s.applied : s.applied - target;
+    if (delta > deadband) return true;
+    // Within the deadband: only re-assert periodically
+    return reassertInterval_.count() > 0 && now - s.written >= reassertInterval_;
+}
+
+bool Actuator::writeFailed(Device& d, Setting& s, const char* what, const std::exception& e, Clock::time_point now) {
+    d.stats.writeErrors++;
+    s.applied = -1;
+    auto error = dynamic_cast<const BackendError*>(&e);
+    if (error && error->isPermanent()) {
+        // Missing root or a board without the feature; retrying would fail the same way forever
+        std::cerr << "[Actuator] " << what << " control disabled: " << e.what() << std::endl;
+        s.supported = false;
+        return true;
+    }
+    if (!s.failing) {
+        std::cerr << "[Actuator] " << what << " write failed, retrying every " << RETRY_BACKOFF.count() << "s: " << e.what() << std::endl;
+    }
+    s.failing = true;
+    s.retryAt = now + RETRY_BACKOFF;
+    return false;
+}
+
+void Actuator::writeSucceeded(Setting& s, const char* what, unsigned int value, Clock::time_point now) {
+    if (s.failing) std::cout << "[Actuator] " << what << " writes succeeding again" << std::endl;
+    s.failing = false;
+    s.applied = value;
+    s.written = now;
+}
+
+void Actuator::applyFanSpeed(unsigned int device, unsigned int speedPercent) {
+    for (unsigned int fan = 0; fan < getNumFans(device); ++fan) {
+        applyFanSpeed(device, fan, speedPercent);
+    }
+}
+
+void Actuator::applyFanSpeed(unsigned int device, unsigned int fan, unsigned int speedPercent) {
+    Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    if (fan >= d.fans.size()) return;
+
+    Setting& s = d.fans[fan];
+    if (!s.supported) return;
+    auto now = Clock::now();
+    if (!shouldWrite(s, speedPercent, fanDeadband_, now)) {
+        d.stats.fanWritesSuppressed++;
+        return;
+    }
+    try {
+        backend_.setFanSpeed(d.handle, fan, speedPercent);
+    } catch (const std::exception& e) {
+        writeFailed(d, s, "Fan", e, now);
+        return;
+    }
+    writeSucceeded(s, "Fan", speedPercent, now);
+    d.stats.fanWrites++;
+}
+
+unsigned int Actuator::applyPowerLimit(unsigned int device, unsigned int watts) {
+    Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    if (!d.powerSupported || !d.power.supported) return 0;
+
+    // Clamp target power to hardware limits
+    if (watts < d.minW) watts = d.minW;
+    if (watts > d.maxW) watts = d.maxW;
+
+    Setting& s = d.power;
+    auto now = Clock::now();
+    if (!shouldWrite(s, watts, powerDeadband_, now)) {
+        d.stats.powerWritesSuppressed++;
+        return s.applied < 0 ? 0 : s.applied;
+    }
+    try {
+        backend_.setPowerLimit(d.handle, watts);
+    } catch (const std::exception& e) {
+        writeFailed(d, s, "Power limit", e, now);
+        return 0;
+    }
+    writeSucceeded(s, "Power limit", watts, now);
+    d.stats.powerWrites++;
+    return watts;
+}
+
+void Actuator::applyClock(Device& d, bool memory, unsigned int mhz, Clock::time_point now) {
+    Setting& s = memory ? d.memClock : d.gpuClock;
+    unsigned int maxMHz = memory ? d.maxMemoryMHz : d.maxGraphicsMHz;
+    if (maxMHz && mhz > maxMHz) mhz = maxMHz;
+    if (!shouldWrite(s, mhz, clockDeadband_, now)) {
+        d.stats.clockWritesSuppressed++;
+        return;
+    }
+    try {
+        if (memory) backend_.setMemoryLockedClocks(d.handle, mhz, mhz);
+        else backend_.setGpuLockedClocks(d.handle, mhz, mhz);
+    } catch (const std::exception& e) {
+        if (writeFailed(d, s, memory ? "Memory clock" : "Graphics clock", e, now)) {
+            // Drop whatever this domain still holds; the reset clears both, so the other is rewritten next time
+            try {
+                backend_.resetLockedClocks(d.handle);
+            } catch (const std::exception&) {}
+            d.gpuClock.applied = -1;
+            d.memClock.applied = -1;
+        }
+        return;
+    }
+    writeSucceeded(s, memory ? "Memory clock" : "Graphics clock", mhz, now);
+    d.stats.clockWrites++;
+}
+
+void Actuator::applyClockLock(unsigned int device, unsigned int graphicsMHz, unsigned int memoryMHz) {
+    Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    auto now = Clock::now();
+    if (graphicsMHz && d.gpuClock.supported) applyClock(d, false, graphicsMHz, now);
+    if (memoryMHz && d.memClock.supported) applyClock(d, true, memoryMHz, now);
+}
+
+void Actuator::resetClocks(unsigned int device) {
+    Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    backend_.resetLockedClocks(d.handle);
+    d.gpuClock.applied = -1;
+    d.memClock.applied = -1;
+}
+
+unsigned int Actuator::getNumFans(unsigned int device) const {
+    return this->device(device).fans.size();
+}
+
+bool Actuator::hasPowerControl(unsigned int device) const {
+    const Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.powerSupported && d.power.supported;
+}
+
+void Actuator::getPowerConstraints(unsigned int device, unsigned int& minW, unsigned int& maxW) const {
+    const Device& d = this->device(device);
+    minW = d.minW;
+    maxW = d.maxW;
+}
+
+bool Actuator::hasClockControl(unsigned int device) const {
+    const Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.gpuClock.supported || d.memClock.supported;
+}
+
+void Actuator::getClockLock(unsigned int device, unsigned int& graphicsMHz, unsigned int& memoryMHz) const {
+    const Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    graphicsMHz = d.gpuClock.applied < 0 ? 0 : d.gpuClock.applied;
+    memoryMHz = d.memClock.applied < 0 ? 0 : d.memClock.applied;
+}
+
+void Actuator::invalidate(unsigned int device) {
+    Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (auto& fan : d.fans) fan.applied = -1;
+    d.power.applied = -1;
+    d.gpuClock.applied = -1;
+    d.memClock.applied = -1;
+}
+
+ActuationStats Actuator::getStats(unsigned int device) const {
+    const Device& d = this->device(device);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.stats;
+}
+
+} // namespace temper
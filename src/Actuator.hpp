@@ -0,0 +1,116 @@
+#pragma once
+
+#include "GpuBackend.hpp"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace temper {
+
+struct ActuationStats {
+    unsigned long long fanWrites = 0;
+    unsigned long long fanWritesSuppressed = 0;
+    unsigned long long powerWrites = 0;
+    unsigned long long powerWritesSuppressed = 0;
+    unsigned long long clockWrites = 0;
+    unsigned long long clockWritesSuppressed = 0;
+    unsigned long long writeErrors = 0;
+};
+
+// Write-suppressing front end for fan and power actuation.
+//
+// Fan count and power-limit constraints are probed once per device. A write
+// reaches the driver only when the target moves beyond the deadband from the
+// last applied value, or when the re-assert interval expires (in case the
+// driver or another tool changed the setting behind our back). Failed writes
+// are counted and logged, never thrown. A write refused as unsupported or not
+// permitted disables that setting for good; any other failure is retried
+// after a back-off and logged once until a write succeeds again.
+//
+// Each device has its own lock, so a write stuck in the driver holds up only
+// that device. Fan count and power constraints never change after addDevice
+// and are read without it.
+//
+// Configuration (environment):
+//   FAN_DEADBAND            Fan change in % that is ignored (default 0: write on any change)
+//   POWER_DEADBAND_W        Power limit change in W that is ignored (default 0)
+//   CLOCK_DEADBAND_MHZ      Locked clock change in MHz that is ignored (default 0)
+//   ACTUATION_REASSERT_SEC  Rewrite unchanged targets after this many seconds (default 30)
+class Actuator {
+public:
+    explicit Actuator(GpuBackend& backend);
+
+    // Probes capabilities; device indices follow the order of addDevice calls
+    void addDevice(nvmlDevice_t handle);
+
+    void applyFanSpeed(unsigned int device, unsigned int speedPercent);
+    void applyFanSpeed(unsigned int device, unsigned int fan, unsigned int speedPercent);
+    // Clamps to the device constraints and returns the limit now in effect (W), 0 if unknown
+    unsigned int applyPowerLimit(unsigned int device, unsigned int watts);
+    // Pins graphics/memory clocks (MHz, 0 leaves that domain alone), clamped to the
+    // device maximum. A lock refused as unsupported or not permitted disables that
+    // domain only and resets the device's locks; the other domain is re-applied
+    // on the next call.
+    void applyClockLock(unsigned int device, unsigned int graphicsMHz, unsigned int memoryMHz);
+    void resetClocks(unsigned int device);
+
+    unsigned int getNumFans(unsigned int device) const;
+    bool hasPowerControl(unsigned int device) const;
+    void getPowerConstraints(unsigned int device, unsigned int& minW, unsigned int& maxW) const;
+    // Either clock domain can still be locked
+    bool hasClockControl(unsigned int device) const;
+    // Locks currently in effect (MHz, 0: driver controlled)
+    void getClockLock(unsigned int device, unsigned int& graphicsMHz, unsigned int& memoryMHz) const;
+
+    // Forget applied values so the next apply always writes (e.g. after restoreAutoFans)
+    void invalidate(unsigned int device);
+
+    ActuationStats getStats(unsigned int device) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Setting {
+        int applied = -1; // -1: unknown, always write
+        Clock::time_point written;
+        Clock::time_point retryAt; // Back-off after a failed write
+        bool failing = false;      // Last write failed transiently
+        bool supported = true;     // false once the driver refused it for good
+    };
+
+    static constexpr std::chrono::seconds RETRY_BACKOFF{5};
+
+    struct Device {
+        mutable std::mutex mutex;
+        nvmlDevice_t handle = nullptr;
+        std::vector<Setting> fans;
+        Setting power;
+        bool powerSupported = false;
+        unsigned int minW = 0;
+        unsigned int maxW = 0;
+        Setting gpuClock;
+        Setting memClock;
+        unsigned int maxGraphicsMHz = 0;
+        unsigned int maxMemoryMHz = 0;
+        ActuationStats stats;
+    };
+
+    Device& device(unsigned int index);
+    const Device& device(unsigned int index) const;
+    bool shouldWrite(const Setting& s, unsigned int target, unsigned int deadband, Clock::time_point now) const;
+    void applyClock(Device& d, bool memory, unsigned int mhz, Clock::time_point now);
+    // true if the failure is permanent and the setting is now disabled
+    bool writeFailed(Device& d, Setting& s, const char* what, const std::exception& e, Clock::time_point now);
+    void writeSucceeded(Setting& s, const char* what, unsigned int value, Clock::time_point now);
+
+    GpuBackend& backend_;
+    std::deque<Device> devices_; // Stable addresses: entries are used outside mutex_
+    unsigned int fanDeadband_ = 0;
+    unsigned int powerDeadband_ = 0;
+    unsigned int clockDeadband_ = 0;
+    Clock::duration reassertInterval_ = std::chrono::seconds(30);
+    mutable std::mutex mutex_; // Guards the device list only
+};
+
+} // namespace temper
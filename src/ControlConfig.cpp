@@ -0,0 +1,183 @@
+#include "ControlConfig.hpp"
+#include "ProcessUtils.hpp"
+#include "CurveRules.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace temper {
+
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+ControlConfig::ControlConfig(const CurveSettings& baseline, const std::vector<std::string>& uuids,
+                             const std::vector<std::string>& names)
+    : baseline_(baseline), uuids_(uuids), names_(names) {
+    std::vector<std::string> problems;
+    auto set = build(baseline_, problems);
+    for (const auto& p : problems) std::cerr << p << std::endl;
+    publish(set, "startup");
+}
+
+ControlConfig::~ControlConfig() {
+    watching_ = false;
+    if (watchThread_.joinable()) watchThread_.join();
+}
+
+std::shared_ptr<CurveSet> ControlConfig::build(const CurveSettings& s, std::vector<std::string>& problems) const {
+    auto set = std::make_shared<CurveSet>();
+    size_t count = uuids_.size();
+    set->fan.resize(count);
+    set->power.resize(count);
+    set->fanRules.resize(count);
+    set->powerRules.resize(count);
+
+    CurveRules fanRules(s.gpuFan.c_str());
+    CurveRules powerRules(s.gpuPower.c_str());
+    if (!fanRules.isValid()) problems.push_back("Invalid GPU_FAN_CURVES: " + s.gpuFan);
+    if (!powerRules.isValid()) problems.push_back("Invalid GPU_POWER_CURVES: " + s.gpuPower);
+
+    for (size_t i = 0; i < count; ++i) {
+        std::string fanCurve = fanRules.select(i, uuids_[i], names_[i], s.fan, set->fanRules[i]);
+        std::string powerCurve = powerRules.select(i, uuids_[i], names_[i], s.power, set->powerRules[i]);
+        if (!set->fan[i].parseSetpoints(fanCurve)) problems.push_back("Invalid fan curve for GPU " + std::to_string(i) + ": " + fanCurve);
+        if (!set->power[i].parseSetpoints(powerCurve)) problems.push_back("Invalid power curve for GPU " + std::to_string(i) + ": " + powerCurve);
+        if (set->power[i].isPid()) {
+            problems.push_back("PID mode only applies to fan curves; no power curve for GPU " + std::to_string(i));
+            set->power[i].parseSetpoints("");
+        }
+        set->anyPower = set->anyPower || !set->power[i].isEmpty();
+    }
+
+    const std::string& chassis = s.chassis.empty() ? s.fan : s.chassis; // Default to GPU curve
+    if (!set->chassis.parseSetpoints(chassis)) problems.push_back("Invalid chassis fan curve: " + chassis);
+    return set;
+}
+
+void ControlConfig::publish(std::shared_ptr<CurveSet> set, const std::string& source) {
+    set->generation = status_.generation + 1;
+    status_.generation = set->generation;
+    status_.source = source;
+    status_.appliedAt = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (size_t i = 0; i < set->fanRules.size(); ++i) {
+        if (set->fanRules[i] != "default" || set->powerRules[i] != "default") {
+            std::cout << "[" << i << "] Curves: fan from '" << set->fanRules[i] << "', power from '" << set->powerRules[i] << "'" << std::endl;
+        }
+    }
+    std::atomic_store(&current_, std::move(set));
+}
+
+bool ControlConfig::apply(const std::string& text, const std::string& source, std::string& error, bool requireKeys) {
+    CurveSettings settings = baseline_;
+    std::vector<std::string> problems;
+    unsigned int keys = 0;
+    std::stringstream ss(text);
+    std::string line;
+    unsigned int lineNo = 0;
+    while (std::getline(ss, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        auto eq = line.find('=');
+        std::string key = trim(line.substr(0, eq));
+        std::string value = eq == std::string::npos ? "" : trim(line.substr(eq + 1));
+        if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        }
+        keys++;
+        if (eq == std::string::npos) problems.push_back("line " + std::to_string(lineNo) + ": expected KEY=VALUE");
+        else if (key == "FAN_SETPOINTS") settings.fan = value;
+        else if (key == "POWER_SETPOINTS") settings.power = value;
+        else if (key == "CHASSIS_FAN_SETPOINTS") settings.chassis = value;
+        else if (key == "GPU_FAN_CURVES") settings.gpuFan = value;
+        else if (key == "GPU_POWER_CURVES") settings.gpuPower = value;
+        else problems.push_back("line " + std::to_string(lineNo) + ": unknown key " + key);
+    }
+    if (requireKeys && keys == 0) problems.push_back("no settings in config");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<CurveSet> set;
+    if (problems.empty()) set = build(settings, problems);
+    if (!problems.empty()) {
+        error = problems.front();
+        for (size_t p = 1; p < problems.size(); ++p) error += "; " + problems[p];
+        status_.rejected++;
+        status_.lastError = error;
+        std::cerr << "[Config] Rejected " << source << " config, keeping generation " << status_.generation
+                  << ": " << error << std::endl;
+        return false;
+    }
+    publish(set, source);
+    std::cout << "[Config] Applied " << source << " config as generation " << status_.generation << std::endl;
+    return true;
+}
+
+bool ControlConfig::applyFile(const std::string& source) {
+    std::ifstream in(path_);
+    if (!in) return false;
+    std::stringstream content;
+    content << in.rdbuf();
+    std::string error;
+    return apply(content.str(), source, error);
+}
+
+void ControlConfig::watch(const std::string& path) {
+    path_ = path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.file = path;
+    }
+    if (!applyFile("file")) std::cout << "[Config] " << path << " not readable yet; watching for it" << std::endl;
+    watching_ = true;
+    watchThread_ = std::thread(&ControlConfig::watchLoop, this);
+}
+
+void ControlConfig::watchLoop() {
+    blockShutdownSignals();
+
+    // Watch the directory: editors and config management replace the file by rename
+    size_t slash = path_.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+    std::string name = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "[Config] Cannot watch " << dir << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (watching_) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) continue;
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n;) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                if (event->len && name == event->name) changed = true;
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) applyFile("file");
+    }
+    close(fd);
+}
+
+ConfigStatus ControlConfig::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+} // namespace temper
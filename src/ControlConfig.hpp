@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CurveController.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace temper {
+
+// Curve strings as written in the environment or a config file
+struct CurveSettings {
+    std::string fan;       // FAN_SETPOINTS (at startup: the fanctl arguments)
+    std::string power;     // POWER_SETPOINTS
+    std::string chassis;   // CHASSIS_FAN_SETPOINTS; empty follows the fan curve
+    std::string gpuFan;    // GPU_FAN_CURVES
+    std::string gpuPower;  // GPU_POWER_CURVES
+};
+
+// One generation of parsed curves. Never modified after it is published,
+// except for PID state, which each slot's caller owns (see CurveController).
+struct CurveSet {
+    unsigned long long generation = 0;
+    std::vector<CurveController> fan;   // Per device
+    std::vector<CurveController> power; // Per device
+    std::vector<std::string> fanRules;  // GPU_FAN_CURVES selector per device, or "default"
+    std::vector<std::string> powerRules;
+    CurveController chassis;
+    bool anyPower = false;
+};
+
+struct ConfigStatus {
+    unsigned long long generation = 0;
+    std::string source;        // "startup", "file" or "http"
+    double appliedAt = 0.0;    // Unix seconds
+    std::string file;          // Watched path, empty if none
+    unsigned long long rejected = 0;
+    std::string lastError;     // Why the last rejected config was refused
+};
+
+// Curves that can change while the loop runs.
+//
+// A config is "KEY=VALUE" lines ('#' comments, optional quotes) for the
+// keys of CurveSettings. Keys it leaves out fall back to the startup
+// environment, so deleting a line undoes it. A new config is parsed in full
+// on the caller's thread (the file watcher or the HTTP server). If any curve
+// or rule in it is malformed it is rejected and the running curves stay.
+// Otherwise it is published with one atomic pointer swap. The loop picks up
+// the current set once per tick and keeps it for that tick; PID loops start
+// over in a new set.
+//
+// Configuration (environment):
+//   CONFIG_FILE  Watched with inotify and applied on every write or rename-over (unset: off)
+class ControlConfig {
+public:
+    ControlConfig(const CurveSettings& baseline, const std::vector<std::string>& uuids,
+                  const std::vector<std::string>& names);
+    ~ControlConfig();
+
+    std::shared_ptr<CurveSet> current() const { return std::atomic_load(&current_); }
+
+    // false (with the reason in `error`) if the config was rejected. With
+    // requireKeys a config that sets nothing is rejected rather than taken as
+    // a return to the startup curves.
+    bool apply(const std::string& text, const std::string& source, std::string& error, bool requireKeys = false);
+    // Applies the file now (if it exists) and again whenever it changes
+    void watch(const std::string& path);
+
+    ConfigStatus getStatus() const;
+
+private:
+    // Problems found while building; at startup they are warnings, afterwards grounds for rejection
+    std::shared_ptr<CurveSet> build(const CurveSettings& settings, std::vector<std::string>& problems) const;
+    void publish(std::shared_ptr<CurveSet> set, const std::string& source);
+    void watchLoop();
+    bool applyFile(const std::string& source);
+
+    CurveSettings baseline_;
+    std::vector<std::string> uuids_;
+    std::vector<std::string> names_;
+
+    std::shared_ptr<CurveSet> current_; // Only through std::atomic_load/std::atomic_store
+
+    mutable std::mutex mutex_; // Serializes apply() and guards status_
+    ConfigStatus status_;
+
+    std::string path_;
+    std::atomic<bool> watching_{false};
+    std::thread watchThread_;
+};
+
+} // namespace temper
@@ -1,46 +1,195 @@
 #include "CurveController.hpp"
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
 #include <iostream>
 
 namespace temper {
 
-void CurveController::parseSetpoints(const std::string& setpointString) {
+bool CurveController::parseSetpoints(const std::string& setpointString) {
     points_.clear();
+    pidEnabled_ = false;
+    pidTargets_.clear();
     std::stringstream ss(setpointString);
     std::string token;
+    bool valid = true;
     
     while (ss >> token) {
         auto colonPos = token.find(':');
         if (colonPos != std::string::npos) {
             try {
+                if (std::isalpha((unsigned char)token[0])) {
+                    if (!parsePidToken(token.substr(0, colonPos), token.substr(colonPos + 1))) {
+                        std::cerr << "[Curve] Ignoring unknown option: " << token << std::endl;
+                        valid = false;
+                    }
+                    continue;
+                }
                 unsigned int temp = std::stoul(token.substr(0, colonPos));
                 unsigned int val = std::stoul(token.substr(colonPos + 1));
                 points_.push_back({temp, val});
             } catch (...) {
                 // Skip invalid tokens
+                valid = false;
             }
+        } else {
+            valid = false;
         }
     }
     
-    std::sort(points_.begin(), points_.end());
+    std::stable_sort(points_.begin(), points_.end());
+    compile();
+
+    pidEnabled_ = !pidTargets_.empty();
+    if (outMin_ > outMax_) std::swap(outMin_, outMax_);
+    pidStates_.assign(pidEnabled_ ? CHASSIS_SLOT + 1 : 0, PidState());
+    return valid;
 }
 
-unsigned int CurveController::interpolate(unsigned int currentTemp) const {
+bool CurveController::parsePidToken(const std::string& key, const std::string& value) {
+    if (key == "pid") {
+        std::string list(value);
+        std::replace(list.begin(), list.end(), ',', ' ');
+        std::stringstream ss(list);
+        double target;
+        while (ss >> target) pidTargets_.push_back(target);
+        return !pidTargets_.empty();
+    }
+    double v = std::stod(value);
+    if (key == "kp") kp_ = v;
+    else if (key == "ki") ki_ = v;
+    else if (key == "kd") kd_ = v;
+    else if (key == "min") outMin_ = std::clamp(v, 0.0, 100.0);
+    else if (key == "max") outMax_ = std::clamp(v, 0.0, 100.0);
+    else if (key == "period") period_ = std::max(0.0, v);
+    else return false;
+    return true;
+}
+
+// Value at `offset` of `range` along a segment, rounded down
+static unsigned int segmentValue(const CurvePoint& a, const CurvePoint& b, unsigned long long offset, unsigned long long range) {
+    long long valRange = (long long)b.value - a.value;
+    long long scaled = valRange * (long long)offset;
+    long long step = scaled >= 0 ? scaled / (long long)range : -((-scaled + (long long)range - 1) / (long long)range);
+    return (unsigned int)((long long)a.value + step);
+}
+
+void CurveController::compile() {
+    table_.clear();
+    if (points_.empty()) return;
+
+    unsigned long long first = (unsigned long long)points_.front().temp << FRACTION_BITS;
+    unsigned long long last = (unsigned long long)points_.back().temp << FRACTION_BITS;
+    if (last - first + 1 > MAX_TABLE_ENTRIES || last > UINT_MAX) return;
+
+    tableBase_ = (unsigned int)first;
+    table_.resize(last - first + 2);
+    for (size_t i = 0; i + 1 < table_.size(); ++i) {
+        table_[i] = searchSegments(tableBase_ + i);
+    }
+    // Above the last setpoint; differs from the entry before only when all setpoints share one temperature
+    table_.back() = points_.back().value;
+}
+
+unsigned int CurveController::searchSegments(unsigned int tempFixed) const {
     if (points_.empty()) return 0;
-    if (currentTemp <= points_.front().temp) return points_.front().value;
-    if (currentTemp >= points_.back().temp) return points_.back().value;
+    unsigned long long t = tempFixed;
+    if (t <= (unsigned long long)points_.front().temp << FRACTION_BITS) return points_.front().value;
+    if (t >= (unsigned long long)points_.back().temp << FRACTION_BITS) return points_.back().value;
 
     for (size_t i = 0; i < points_.size() - 1; ++i) {
-        if (currentTemp >= points_[i].temp && currentTemp <= points_[i+1].temp) {
-            double tempRange = points_[i+1].temp - points_[i].temp;
-            double valRange = (double)points_[i+1].value - points_[i].value;
-            double tempOffset = (double)currentTemp - points_[i].temp;
-            
-            return (unsigned int)(points_[i].value + (valRange * tempOffset / tempRange));
+        unsigned long long lo = (unsigned long long)points_[i].temp << FRACTION_BITS;
+        unsigned long long hi = (unsigned long long)points_[i+1].temp << FRACTION_BITS;
+        if (t >= lo && t <= hi) {
+            if (t == lo) return points_[i].value;
+            return segmentValue(points_[i], points_[i+1], t - lo, hi - lo);
         }
     }
     return points_.front().value;
 }
 
+unsigned int CurveController::toFixed(double temp) {
+    if (temp <= 0.0) return 0;
+    double scaled = temp * (1u << FRACTION_BITS);
+    return scaled >= (double)UINT_MAX ? UINT_MAX : (unsigned int)scaled;
+}
+
+unsigned int CurveController::interpolate(unsigned int currentTemp) const {
+    if (currentTemp > (UINT_MAX >> FRACTION_BITS)) currentTemp = UINT_MAX >> FRACTION_BITS;
+    return interpolateFixed(currentTemp << FRACTION_BITS);
+}
+
+unsigned int CurveController::interpolateFixed(unsigned int tempFixed) const {
+    if (table_.empty()) return searchSegments(tempFixed);
+    unsigned int index = tempFixed > tableBase_ ? tempFixed - tableBase_ : 0;
+    return table_[std::min<size_t>(index, table_.size() - 1)];
+}
+
+unsigned int CurveController::evaluate(unsigned int slot, double temp) {
+    if (!pidEnabled_) return interpolateFixed(toFixed(temp));
+    if (slot >= pidStates_.size()) return (unsigned int)outMax_;
+
+    PidState& st = pidStates_[slot];
+    PidStatus& s = st.status;
+    auto now = std::chrono::steady_clock::now();
+    double dt = std::chrono::duration<double>(now - st.lastRun).count();
+    if (st.started && dt < period_) return (unsigned int)std::lround(s.output);
+
+    s.enabled = true;
+    s.target = pidTarget(slot);
+    s.error = temp - s.target;
+    if (!st.started) {
+        // No history yet for the derivative. The integral starts where the output
+        // continues from the previous controller, or at the minimum output.
+        st.started = true;
+        s.integral = st.seed >= 0.0 ? std::clamp(st.seed - kp_ * s.error, outMin_, outMax_) : outMin_;
+        dt = 0.0;
+    }
+
+    // Derivative on the measurement, so a target change doesn't kick the output
+    double derivative = dt > 0.0 ? (temp - st.lastTemp) / dt : 0.0;
+    double unclamped = kp_ * s.error + s.integral + kd_ * derivative;
+
+    // Anti-windup: only integrate while that doesn't push a saturated output further out
+    bool pushingHigh = unclamped >= outMax_ && s.error > 0.0;
+    bool pushingLow = unclamped <= outMin_ && s.error < 0.0;
+    if (!pushingHigh && !pushingLow) {
+        s.integral = std::clamp(s.integral + ki_ * s.error * dt, outMin_, outMax_);
+    }
+
+    s.output = std::clamp(kp_ * s.error + s.integral + kd_ * derivative, outMin_, outMax_);
+    st.lastTemp = temp;
+    st.lastRun = now;
+    return (unsigned int)std::lround(s.output);
+}
+
+double CurveController::pidTarget(unsigned int slot) const {
+    return pidTargets_.size() == 1 || slot >= pidTargets_.size() ? pidTargets_[0] : pidTargets_[slot];
+}
+
+bool CurveController::samePid(const CurveController& other, unsigned int slot) const {
+    return pidEnabled_ && other.pidEnabled_ && pidTarget(slot) == other.pidTarget(slot) &&
+           kp_ == other.kp_ && ki_ == other.ki_ && kd_ == other.kd_ &&
+           outMin_ == other.outMin_ && outMax_ == other.outMax_ && period_ == other.period_;
+}
+
+void CurveController::continueFrom(unsigned int slot, const CurveController& previous, double lastOutput) {
+    if (!pidEnabled_ || slot >= pidStates_.size() || pidStates_[slot].started) return;
+    if (samePid(previous, slot) && slot < previous.pidStates_.size()) {
+        pidStates_[slot] = previous.pidStates_[slot];
+        return;
+    }
+    if (previous.pidEnabled_ && slot < previous.pidStates_.size() && previous.pidStates_[slot].started) {
+        lastOutput = previous.pidStates_[slot].status.output;
+    }
+    pidStates_[slot].seed = lastOutput;
+}
+
+CurveController::PidStatus CurveController::getPidStatus(unsigned int slot) const {
+    if (slot >= pidStates_.size()) return PidStatus();
+    return pidStates_[slot].status;
+}
+
 } // namespace temper
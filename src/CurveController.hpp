@@ -1,23 +1,97 @@
 #pragma once
 
 #include "Common.hpp"
+#include <chrono>
+#include <cstddef>
 #include <vector>
 #include <string>
 
 namespace temper {
 
+// Piecewise-linear "temp:value" curve.
+//
+// Parsing compiles the curve into a dense table with one integer target per
+// 1/16 degree between the first and last setpoint, so a lookup is a clamp and
+// an index. Values match the segment interpolation exactly (rounded down).
+// Curves spanning more than MAX_TABLE_ENTRIES steps fall back to searching
+// the segments.
+//
+// A "pid:<target>" token switches to closed-loop mode: the output holds the
+// input at the target temperature instead of following setpoints. Targets
+// can be given per device ("pid:75,70,80"); more tokens tune the loop:
+//   kp:<%/C>  ki:<%/C/s>  kd:<%s/C>  min:<%>  max:<%>  period:<s>
+// (defaults 5, 0.2, 0, 0, 100, 1). The loop runs at most once per period on
+// the measured time since its last run; the integral stops accumulating
+// while the output is saturated (anti-windup). Each device (or any other
+// slot id, e.g. the chassis) keeps its own state, touched only by its caller.
+// When a reloaded curve replaces a controller, continueFrom() keeps a loop
+// whose target and gains are unchanged running as it was, and starts a
+// changed one from the last output rather than from the minimum.
 class CurveController {
 public:
+    struct PidStatus {
+        bool enabled = false;
+        double target = 0.0;
+        double error = 0.0;      // Input minus target (C)
+        double integral = 0.0;   // Integral term (%)
+        double output = 0.0;     // Clamped output (%)
+    };
+
+    static constexpr unsigned int CHASSIS_SLOT = MAX_DEVICES; // State slot for the chassis fan loop
+
+    // Fixed-point temperatures carry this many fractional bits (1/16 degree)
+    static constexpr unsigned int FRACTION_BITS = 4;
+
     CurveController() = default;
     
-    void parseSetpoints(const std::string& setpointString);
+    // false if any token was malformed or unknown (the rest still applies)
+    bool parseSetpoints(const std::string& setpointString);
     unsigned int interpolate(unsigned int currentTemp) const;
-    
-    bool isEmpty() const { return points_.empty(); }
+    unsigned int interpolateFixed(unsigned int tempFixed) const;
+
+    static unsigned int toFixed(double temp);
+
+    // Target for `slot`: the curve at `temp`, or one PID step in closed-loop mode
+    unsigned int evaluate(unsigned int slot, double temp);
+    PidStatus getPidStatus(unsigned int slot) const;
+    // Called by the slot's caller before its first evaluate() on this
+    // controller; lastOutput is the target it last applied from `previous`
+    void continueFrom(unsigned int slot, const CurveController& previous, double lastOutput);
+
+    bool isPid() const { return pidEnabled_; }
+    bool isEmpty() const { return points_.empty() && !pidEnabled_; }
     const std::vector<CurvePoint>& getPoints() const { return points_; }
 
 private:
+    static constexpr size_t MAX_TABLE_ENTRIES = 1 << 16;
+
+    struct PidState {
+        bool started = false;
+        double seed = -1.0;    // Output the first run continues from, <0: start at the minimum
+        PidStatus status;
+        double lastTemp = 0.0;
+        std::chrono::steady_clock::time_point lastRun;
+    };
+
+    void compile();
+    unsigned int searchSegments(unsigned int tempFixed) const;
+    bool parsePidToken(const std::string& key, const std::string& value);
+    double pidTarget(unsigned int slot) const;
+    bool samePid(const CurveController& other, unsigned int slot) const;
+
     std::vector<CurvePoint> points_;
+    std::vector<unsigned int> table_; // Target per fixed-point step from tableBase_
+    unsigned int tableBase_ = 0;
+
+    bool pidEnabled_ = false;
+    std::vector<double> pidTargets_; // One for all slots, or per device index
+    double kp_ = 5.0;
+    double ki_ = 0.2;
+    double kd_ = 0.0;
+    double outMin_ = 0.0;
+    double outMax_ = 100.0;
+    double period_ = 1.0;
+    std::vector<PidState> pidStates_; // Indexed by slot; sized at parse so lookups never allocate
 };
 
 } // namespace temper
@@ -0,0 +1,72 @@
+#include "CurveRules.hpp"
+#include "CurveController.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fnmatch.h>
+#include <iostream>
+#include <sstream>
+
+namespace temper {
+
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+CurveRules::CurveRules(const char* spec) {
+    if (!spec) return;
+    std::stringstream ss(spec);
+    std::string entry;
+    while (std::getline(ss, entry, ';')) {
+        auto eq = entry.find('=');
+        if (eq == std::string::npos) {
+            if (!trim(entry).empty()) {
+                std::cerr << "[Curves] Ignoring rule without '=': " << entry << std::endl;
+                valid_ = false;
+            }
+            continue;
+        }
+        Rule r;
+        r.selector = trim(entry.substr(0, eq));
+        r.setpoints = trim(entry.substr(eq + 1));
+        CurveController probe; // Checked here so a rule no GPU matches yet can't hide a typo
+        if (r.selector.empty() || !probe.parseSetpoints(r.setpoints)) {
+            std::cerr << "[Curves] Invalid rule: " << trim(entry) << std::endl;
+            valid_ = false;
+            if (r.selector.empty()) continue;
+        }
+        if (r.selector.rfind("name:", 0) == 0) {
+            r.kind = BY_NAME;
+            r.match = r.selector.substr(5);
+        } else if (!r.selector.empty() && std::all_of(r.selector.begin(), r.selector.end(), ::isdigit)) {
+            r.kind = BY_INDEX;
+            r.match = r.selector;
+        } else {
+            r.kind = BY_UUID;
+            r.match = r.selector;
+        }
+        rules_.push_back(r);
+    }
+}
+
+std::string CurveRules::select(unsigned int index, const std::string& uuid, const std::string& name,
+                               const std::string& fallback, std::string& rule) const {
+    for (Kind kind : {BY_UUID, BY_INDEX, BY_NAME}) {
+        for (const auto& r : rules_) {
+            if (r.kind != kind) continue;
+            bool hit = (kind == BY_UUID && r.match == uuid) ||
+                       (kind == BY_INDEX && r.match == std::to_string(index)) ||
+                       (kind == BY_NAME && fnmatch(r.match.c_str(), name.c_str(), 0) == 0);
+            if (hit) {
+                rule = r.selector;
+                return r.setpoints;
+            }
+        }
+    }
+    rule = "default";
+    return fallback;
+}
+
+} // namespace temper
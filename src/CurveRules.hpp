@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace temper {
+
+// Per-device curve selection, resolved once at startup.
+//
+// A rule list is "selector=setpoints" entries separated by ';', e.g.
+//   "GPU-8d2c...=50:40 80:100; 3=pid:70; name:*A100*=45:30 85:100"
+// The selector is a GPU index, "name:<glob>" matched against the model name,
+// or an exact UUID. A UUID rule beats an index rule, which beats a name rule;
+// among rules of one kind the first listed wins. Devices no rule matches get
+// the default curve.
+class CurveRules {
+public:
+    explicit CurveRules(const char* spec);
+
+    // Setpoints for the device, or `fallback`; `rule` gets the matching selector ("default" if none)
+    std::string select(unsigned int index, const std::string& uuid, const std::string& name,
+                       const std::string& fallback, std::string& rule) const;
+
+    bool isEmpty() const { return rules_.empty(); }
+    // false if an entry had to be ignored
+    bool isValid() const { return valid_; }
+
+private:
+    enum Kind { BY_UUID, BY_INDEX, BY_NAME };
+
+    struct Rule {
+        Kind kind;
+        std::string selector; // As written, for logs
+        std::string match;    // UUID, index digits or glob
+        std::string setpoints;
+    };
+
+    std::vector<Rule> rules_;
+    bool valid_ = true;
+};
+
+} // namespace temper
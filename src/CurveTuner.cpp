@@ -0,0 +1,315 @@
+#include "CurveTuner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace temper {
+
+CurveTuner::CurveTuner(const TuneOptions& options) : options_(options) {
+    options_.percentile = std::clamp(options_.percentile, 0.0, 100.0);
+    options_.minFan = std::min(options_.minFan, 100u);
+}
+
+static std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) fields.push_back(field);
+    return fields;
+}
+
+bool CurveTuner::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[Tune] Cannot open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line)) {
+        std::cerr << "[Tune] " << path << " is empty" << std::endl;
+        return false;
+    }
+    std::map<std::string, size_t> columns;
+    auto header = splitCsv(line);
+    for (size_t c = 0; c < header.size(); ++c) columns[header[c]] = c;
+    for (const char* required : {"time", "gpu", "temp_c", "fan_pct", "power_w"}) {
+        if (!columns.count(required)) {
+            std::cerr << "[Tune] " << path << " has no '" << required << "' column" << std::endl;
+            return false;
+        }
+    }
+    auto column = [&](const char* name) { return columns.count(name) ? (long)columns[name] : -1L; };
+    long cTime = column("time"), cGpu = column("gpu"), cTemp = column("temp_c"), cFan = column("fan_pct");
+    long cPower = column("power_w"), cUuid = column("uuid"), cThrottle = column("thermal_throttle_sec");
+    long cSlowdown = column("slowdown_c");
+
+    std::map<unsigned int, Series> byGpu;
+    size_t skipped = 0;
+    while (std::getline(in, line)) {
+        auto f = splitCsv(line);
+        if (f.size() < header.size()) {
+            if (!line.empty()) skipped++;
+            continue;
+        }
+        try {
+            unsigned int gpu = std::stoul(f[cGpu]);
+            Sample s{std::stod(f[cTime]), std::stod(f[cTemp]), std::stod(f[cFan]), std::stod(f[cPower]),
+                     cThrottle >= 0 ? std::stod(f[cThrottle]) : 0.0};
+            Series& series = byGpu[gpu];
+            series.gpu = gpu;
+            if (cUuid >= 0 && !f[cUuid].empty()) series.uuid = f[cUuid];
+            if (cSlowdown >= 0) series.slowdownC = std::max(series.slowdownC, (unsigned int)std::stoul(f[cSlowdown]));
+            series.samples.push_back(s);
+        } catch (...) {
+            skipped++;
+        }
+    }
+    if (skipped) std::cerr << "[Tune] Skipped " << skipped << " malformed row(s)" << std::endl;
+
+    series_.clear();
+    for (auto& [gpu, s] : byGpu) {
+        // Appended recordings from several runs may interleave; replay in time order
+        std::stable_sort(s.samples.begin(), s.samples.end(),
+                         [](const Sample& a, const Sample& b) { return a.time < b.time; });
+        series_.push_back(std::move(s));
+    }
+    if (series_.empty()) {
+        std::cerr << "[Tune] No samples in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Cooling rate k and drive at a fan speed: dT/dt = drive - k*T (no inlet reading in recordings)
+static void coefficients(const ThermalModel::Vec& t, double powerW, double fan, double& k, double& drive) {
+    k = -(t[1] / 10.0 + t[2] * fan / 1000.0);
+    drive = t[0] * powerW / 100.0 + t[3] * fan / 100.0 + t[4];
+}
+
+// Exact solution with power and fan held over dt, so long steps stay stable
+static double advance(const ThermalModel::Vec& t, double temp, double powerW, double fan, double dt) {
+    double k, drive;
+    coefficients(t, powerW, fan, k, drive);
+    if (k <= 1e-6) return temp + drive * dt;
+    double steady = drive / k;
+    return steady + (temp - steady) * std::exp(-k * dt);
+}
+
+CurveTuner::Fit CurveTuner::fit(const Series& s) const {
+    constexpr int N = ThermalModel::N;
+    double a[N][N + 1] = {};
+    size_t pairs = 0;
+    for (size_t k = 0; k + 1 < s.samples.size(); ++k) {
+        const Sample& p = s.samples[k];
+        const Sample& q = s.samples[k + 1];
+        double dt = q.time - p.time;
+        if (dt <= 0.0 || dt > MAX_GAP_SEC) continue;
+        auto x = ThermalModel::regressors(p.temp, p.powerW, p.fan, 0.0);
+        double y = (q.temp - p.temp) / dt;
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) a[i][j] += x[i] * x[j];
+            a[i][N] += x[i] * y;
+        }
+        pairs++;
+    }
+    Fit f;
+    if (pairs < 60) return f;
+
+    // Recorded fans follow temperature through the old curve, so the plain fan term
+    // and fan*rise can't be told apart: pin the former to 0 and fit cooling only
+    for (int j = 0; j < N; ++j) a[FAN_TERM][j] = a[j][FAN_TERM] = 0.0;
+    a[FAN_TERM][N] = 0.0;
+    a[FAN_TERM][FAN_TERM] = 1.0;
+
+    // Normal equations by Gaussian elimination; a tiny ridge keeps a constant fan from making them singular
+    for (int i = 0; i < N; ++i) a[i][i] += 1e-6 * pairs;
+    for (int c = 0; c < N; ++c) {
+        int pivot = c;
+        for (int r = c + 1; r < N; ++r) {
+            if (std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+        }
+        if (std::fabs(a[pivot][c]) < 1e-12) return f;
+        for (int j = 0; j <= N; ++j) std::swap(a[c][j], a[pivot][j]);
+        for (int r = 0; r < N; ++r) {
+            if (r == c) continue;
+            double factor = a[r][c] / a[c][c];
+            for (int j = c; j <= N; ++j) a[r][j] -= factor * a[c][j];
+        }
+    }
+    for (int i = 0; i < N; ++i) f.theta[i] = a[i][N] / a[i][i];
+
+    // The replay needs a GPU that heats with power and cools toward a steady state, faster with more fan
+    double kLo, kHi, drive;
+    coefficients(f.theta, 0.0, options_.minFan, kLo, drive);
+    coefficients(f.theta, 0.0, 100.0, kHi, drive);
+    f.ok = f.theta[0] > 0.0 && kLo > 1e-4 && kHi > kLo;
+    return f;
+}
+
+double CurveTuner::rmse(const Series& s, const Fit& f) const {
+    double temp = s.samples[0].temp, sum = 0.0;
+    for (size_t k = 0; k + 1 < s.samples.size(); ++k) {
+        const Sample& p = s.samples[k];
+        double dt = s.samples[k + 1].time - p.time;
+        temp = dt <= 0.0 || dt > MAX_GAP_SEC ? s.samples[k + 1].temp : advance(f.theta, temp, p.powerW, p.fan, dt);
+        double err = temp - s.samples[k + 1].temp;
+        sum += err * err;
+    }
+    return std::sqrt(sum / std::max<size_t>(1, s.samples.size() - 1));
+}
+
+CurveTuner::Replay CurveTuner::replay(const Series& s, const Fit& f, const CurveController& curve, double limitC,
+                                      std::atomic<double>& bestFanSum) const {
+    // 0.1 C histogram: percentiles without sorting each replay
+    constexpr int BINS = 2000;
+    std::vector<unsigned int> histogram(BINS, 0);
+    size_t n = s.samples.size();
+    size_t allowedAbove = (size_t)std::floor((1.0 - options_.percentile / 100.0) * n);
+    size_t above = 0;
+    double fanSum = 0.0;
+    double floorFan = curve.interpolate(0); // Candidates never go below their first point
+
+    Replay r;
+    double temp = s.samples[0].temp;
+    for (size_t k = 0; k < n; ++k) {
+        const Sample& p = s.samples[k];
+        if (limitC > 0.0 && temp >= limitC) return r;
+        if (temp > options_.targetC && ++above > allowedAbove) return r;
+        r.maxC = std::max(r.maxC, temp);
+        histogram[std::clamp((int)(temp * 10.0), 0, BINS - 1)]++;
+
+        double fan = curve.interpolateFixed(CurveController::toFixed(temp));
+        fanSum += fan;
+        // Even at the floor from here on it would use more fan than the best so far. Strictly
+        // more only, so ties are kept and the pick doesn't depend on thread timing
+        if ((k & 255) == 0 && fanSum + floorFan * (n - k - 1) > bestFanSum.load(std::memory_order_relaxed) + 1e-6) return r;
+        if (k + 1 == n) break;
+        double dt = s.samples[k + 1].time - p.time;
+        temp = dt <= 0.0 || dt > MAX_GAP_SEC ? s.samples[k + 1].temp : advance(f.theta, temp, p.powerW, fan, dt);
+    }
+
+    size_t rank = (size_t)std::ceil(options_.percentile / 100.0 * n), seen = 0;
+    for (int b = 0; b < BINS; ++b) {
+        seen += histogram[b];
+        if (seen >= std::max<size_t>(rank, 1)) {
+            r.percentileC = (b + 1) / 10.0;
+            break;
+        }
+    }
+    r.fanAvg = fanSum / n;
+    r.pass = true;
+    double best = bestFanSum.load();
+    while (fanSum < best && !bestFanSum.compare_exchange_weak(best, fanSum)) {
+    }
+    return r;
+}
+
+double CurveTuner::throttleLimit(const Series& s) {
+    double limit = s.slowdownC;
+    for (size_t k = 1; k < s.samples.size(); ++k) {
+        // Counter went up: this temperature already throttled, whatever the nominal threshold says
+        if (s.samples[k].throttleSec > s.samples[k - 1].throttleSec + 1e-3) {
+            double t = s.samples[k].temp;
+            limit = limit > 0.0 ? std::min(limit, t) : t;
+        }
+    }
+    return limit;
+}
+
+std::vector<std::string> CurveTuner::candidates() const {
+    std::vector<std::string> out;
+    unsigned int floor = options_.minFan;
+    unsigned int target = (unsigned int)std::max(30.0, options_.targetC);
+    // Least aggressive first, so the fan bound in replay() tightens early
+    for (unsigned int start = target; start >= 20; start -= 2) {
+        for (unsigned int full = target + 20; full >= start + 4; full -= 2) {
+            unsigned int mid = (start + full) / 2;
+            for (double knee : {0.25, 0.5, 0.75}) {
+                unsigned int midFan = floor + (unsigned int)std::lround(knee * (100 - floor));
+                out.push_back(std::to_string(start) + ":" + std::to_string(floor) + " " + std::to_string(mid) + ":" +
+                              std::to_string(midFan) + " " + std::to_string(full) + ":100");
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<TuneResult> CurveTuner::run() const {
+    std::vector<TuneResult> results(series_.size());
+    std::vector<Fit> fits(series_.size());
+    std::vector<double> limits(series_.size());
+    for (size_t g = 0; g < series_.size(); ++g) {
+        const Series& s = series_[g];
+        TuneResult& r = results[g];
+        r.gpu = s.gpu;
+        r.uuid = s.uuid;
+        r.samples = s.samples.size();
+        r.throttleLimitC = limits[g] = throttleLimit(s);
+        std::vector<double> temps;
+        for (const auto& p : s.samples) {
+            r.recordedFanAvg += p.fan;
+            temps.push_back(p.temp);
+        }
+        r.recordedFanAvg /= std::max<size_t>(1, r.samples);
+        size_t rank = std::clamp<size_t>((size_t)std::ceil(options_.percentile / 100.0 * temps.size()), 1, temps.size()) - 1;
+        std::nth_element(temps.begin(), temps.begin() + rank, temps.end());
+        r.recordedPercentileC = temps[rank];
+
+        fits[g] = fit(s);
+        r.fitted = fits[g].ok;
+        if (!r.fitted) continue;
+        r.fitRmseC = rmse(s, fits[g]);
+        double k, drive;
+        coefficients(fits[g].theta, 0.0, r.recordedFanAvg, k, drive);
+        r.timeConstantSec = 1.0 / k;
+    }
+
+    std::vector<std::string> curves = candidates();
+    std::vector<CurveController> controllers(curves.size());
+    for (size_t c = 0; c < curves.size(); ++c) controllers[c].parseSetpoints(curves[c]);
+
+    // Every (GPU, candidate) replay is independent: hand them out to all cores
+    std::vector<Replay> replays(series_.size() * curves.size());
+    std::unique_ptr<std::atomic<double>[]> bestFanSum(new std::atomic<double>[series_.size()]);
+    for (size_t g = 0; g < series_.size(); ++g) bestFanSum[g] = HUGE_VAL;
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t j; (j = next.fetch_add(1)) < replays.size();) {
+            size_t g = j / curves.size();
+            if (fits[g].ok) replays[j] = replay(series_[g], fits[g], controllers[j % curves.size()], limits[g], bestFanSum[g]);
+        }
+    };
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+
+    for (size_t g = 0; g < series_.size(); ++g) {
+        TuneResult& r = results[g];
+        const Replay* best = nullptr;
+        for (size_t c = 0; c < curves.size(); ++c) {
+            const Replay& rp = replays[g * curves.size() + c];
+            if (!rp.pass) continue;
+            if (!best || rp.fanAvg < best->fanAvg - 1e-9 ||
+                (std::fabs(rp.fanAvg - best->fanAvg) <= 1e-9 && rp.maxC < best->maxC)) {
+                best = &rp;
+                r.setpoints = curves[c];
+            }
+        }
+        if (!best) continue;
+        r.found = true;
+        r.fanAvg = best->fanAvg;
+        r.percentileC = best->percentileC;
+        r.maxC = best->maxC;
+    }
+    return results;
+}
+
+} // namespace temper
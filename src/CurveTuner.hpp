@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CurveController.hpp"
+#include "ThermalModel.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace temper {
+
+struct TuneOptions {
+    double targetC = 0.0;       // The percentile temperature must stay at or below this
+    double percentile = 99.0;
+    unsigned int minFan = 30;   // Lowest fan % a candidate curve may use
+};
+
+struct TuneResult {
+    unsigned int gpu = 0;
+    std::string uuid;
+    size_t samples = 0;
+    bool fitted = false;        // false: too little or too flat data to model this GPU
+    double fitRmseC = 0.0;      // Replay with the recorded fans vs. recorded temperature
+    double timeConstantSec = 0.0; // At the mean recorded fan speed
+    double throttleLimitC = 0.0;  // Slowdown threshold, or the coolest recorded throttle (0: unknown)
+    double recordedFanAvg = 0.0;
+    double recordedPercentileC = 0.0;
+    bool found = false;         // A candidate met the target without throttling
+    std::string setpoints;      // parseSetpoints format
+    double fanAvg = 0.0;        // Replayed with the chosen curve
+    double percentileC = 0.0;
+    double maxC = 0.0;
+};
+
+// Offline fan curve search over recorded telemetry (see TelemetryRecorder).
+//
+// Each GPU's recording is fitted with the same first-order model ThermalModel
+// runs online, by batch least squares over every consecutive sample pair.
+// The recorded power trace is then replayed through that model under each
+// candidate curve: a floor at minFan up to a ramp start, a knee, and 100%
+// at a full-speed temperature. The least aggressive candidate (lowest mean
+// fan) wins if the chosen percentile of replayed temperature is at or below
+// the target and the replay never reaches the throttle limit.
+// GPUs x candidates are spread over all cores, least aggressive first; a
+// replay is abandoned as soon as it can no longer pass or already uses more
+// fan than the best passing curve.
+class CurveTuner {
+public:
+    explicit CurveTuner(const TuneOptions& options);
+
+    // Reads a recording; false (with the reason logged) if nothing usable was found
+    bool load(const std::string& path);
+    std::vector<TuneResult> run() const;
+
+private:
+    struct Sample {
+        double time;
+        double temp;
+        double fan;
+        double powerW;
+        double throttleSec; // Cumulative thermal throttle
+    };
+
+    struct Series {
+        unsigned int gpu = 0;
+        std::string uuid;
+        unsigned int slowdownC = 0;
+        std::vector<Sample> samples;
+    };
+
+    struct Fit {
+        bool ok = false;
+        ThermalModel::Vec theta{};
+    };
+
+    struct Replay {
+        bool pass = false;
+        double fanAvg = 0.0;
+        double percentileC = 0.0;
+        double maxC = 0.0;
+    };
+
+    static constexpr int FAN_TERM = 3;          // Index of the plain fan regressor, not fitted
+    static constexpr double MAX_GAP_SEC = 10.0; // Longer gaps restart the replay from the recorded temperature
+
+    Fit fit(const Series& s) const;
+    double rmse(const Series& s, const Fit& f) const;
+    // bestFanSum: the lowest passing fan total so far for this GPU; replays that exceed it stop early
+    Replay replay(const Series& s, const Fit& f, const CurveController& curve, double limitC,
+                  std::atomic<double>& bestFanSum) const;
+    static double throttleLimit(const Series& s);
+    std::vector<std::string> candidates() const;
+
+    TuneOptions options_;
+    std::vector<Series> series_;
+};
+
+} // namespace temper
@@ -0,0 +1,68 @@
+#include "DeviceWorker.hpp"
+#include "ProcessUtils.hpp"
+#include <iostream>
+
+namespace temper {
+
+DeviceWorker::DeviceWorker() : shared_(std::make_shared<Shared>()) {
+    thread_ = std::thread(run, shared_);
+}
+
+DeviceWorker::~DeviceWorker() {
+    bool stuck;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        shared_->stop = true;
+        stuck = shared_->running;
+    }
+    shared_->cv.notify_all();
+    if (stuck) thread_.detach();
+    else thread_.join();
+}
+
+bool DeviceWorker::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(shared_->mutex);
+        if (shared_->running) return false;
+        shared_->job = std::move(job);
+        shared_->running = true;
+    }
+    shared_->cv.notify_all();
+    return true;
+}
+
+bool DeviceWorker::waitUntil(Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(shared_->mutex);
+    return shared_->cv.wait_until(lock, deadline, [this] { return !shared_->running; });
+}
+
+bool DeviceWorker::busy() const {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    return shared_->running;
+}
+
+void DeviceWorker::run(std::shared_ptr<Shared> shared) {
+    // Shutdown signals go to other threads: this one may be stuck in the driver
+    blockShutdownSignals();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    while (true) {
+        shared->cv.wait(lock, [&] { return shared->stop || shared->job; });
+        if (!shared->job) return; // Stopped while idle
+
+        std::function<void()> job = std::move(shared->job);
+        shared->job = nullptr;
+        lock.unlock();
+        try {
+            job();
+        } catch (const std::exception& e) {
+            std::cerr << "[DeviceWorker] Job failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+        shared->running = false;
+        shared->cv.notify_all();
+        if (shared->stop) return;
+    }
+}
+
+} // namespace temper
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace temper {
+
+// Runs one device's driver calls on its own thread, so a call that blocks
+// (a GPU that fell off the bus can stall NVML for seconds) only holds up that
+// device. The loop submits one job per tick and waits for it up to a
+// deadline; a job that misses it keeps running, and the worker refuses new
+// work until it returns.
+//
+// A worker still stuck at destruction is detached rather than joined.
+class DeviceWorker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    DeviceWorker();
+    ~DeviceWorker();
+
+    DeviceWorker(const DeviceWorker&) = delete;
+    DeviceWorker& operator=(const DeviceWorker&) = delete;
+
+    // Starts the job; false (and the job is dropped) while the previous one is still running
+    bool submit(std::function<void()> job);
+    // True once the submitted job has finished, false if it is still running at the deadline
+    bool waitUntil(Clock::time_point deadline);
+    bool busy() const;
+
+private:
+    // Outlives the worker object when the thread has to be detached
+    struct Shared {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::function<void()> job;
+        bool running = false; // Submitted and not finished
+        bool stop = false;
+    };
+
+    static void run(std::shared_ptr<Shared> shared);
+
+    std::shared_ptr<Shared> shared_;
+    std::thread thread_;
+};
+
+} // namespace temper
@@ -0,0 +1,169 @@
+#include "EnergyMeter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace temper {
+
+EnergyMeter::EnergyMeter() {
+    const char* pEnv = std::getenv("ENERGY_STATE_FILE");
+    if (pEnv) path_ = pEnv;
+
+    const char* cEnv = std::getenv("ENERGY_CHECKPOINT_SEC");
+    if (cEnv) checkpointSec_ = std::strtoul(cEnv, nullptr, 10);
+
+    const char* wEnv = std::getenv("ENERGY_WINDOW_SEC");
+    if (wEnv) windowSec_ = std::max(1ul, std::strtoul(wEnv, nullptr, 10));
+
+    std::ifstream boot("/proc/sys/kernel/random/boot_id");
+    std::getline(boot, bootId_);
+
+    lastCheckpoint_ = Clock::now();
+    load();
+}
+
+void EnergyMeter::load() {
+    std::ifstream file(path_);
+    std::string line;
+    std::string savedBoot;
+    while (std::getline(file, line)) {
+        // Format: "boot_id <id>", then <uuid> <total_mj> <last_raw_counter_mj> per GPU
+        std::istringstream iss(line);
+        std::string uuid;
+        Entry e;
+        if (line.compare(0, 8, "boot_id ") == 0) {
+            savedBoot = line.substr(8);
+        } else if (iss >> uuid >> e.totalMj >> e.lastRaw) {
+            e.haveRaw = e.lastRaw != 0; // 0: entry was integrated from power, no counter to resume
+            entries_[uuid] = e;
+        }
+    }
+    if (entries_.empty()) return;
+
+    bool rebooted = !savedBoot.empty() && !bootId_.empty() && savedBoot != bootId_;
+    if (rebooted) {
+        // The counters restarted at boot: the first reading is all new energy
+        for (auto& entry : entries_) entry.second.lastRaw = 0;
+    }
+    std::cout << "[Energy] Restored counters for " << entries_.size() << " GPU(s) from " << path_
+              << (rebooted ? " (previous boot; counters restart)" : "") << std::endl;
+}
+
+void EnergyMeter::record(Entry& e, Clock::time_point now) {
+    e.lastUpdate = now;
+    e.window.emplace_back(now, e.totalMj);
+    while (e.window.size() > 2 && now - e.window.front().first > std::chrono::seconds(windowSec_)) {
+        e.window.pop_front();
+    }
+}
+
+void EnergyMeter::updateCounter(const std::string& uuid, unsigned long long counterMj) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entries_[uuid];
+    if (e.haveRaw) {
+        e.totalMj += counterMj >= e.lastRaw ? counterMj - e.lastRaw : counterMj;
+    }
+    e.lastRaw = counterMj;
+    e.haveRaw = true;
+    e.exact = true;
+    record(e, Clock::now());
+}
+
+void EnergyMeter::updatePower(const std::string& uuid, double powerMw) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& e = entries_[uuid];
+    auto now = Clock::now();
+    if (e.lastUpdate.time_since_epoch().count() != 0) {
+        e.totalMj += powerMw * std::chrono::duration<double>(now - e.lastUpdate).count();
+    }
+    e.exact = false;
+    record(e, now);
+}
+
+double EnergyMeter::getJoules(const std::string& uuid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(uuid);
+    return it == entries_.end() ? 0.0 : it->second.totalMj / 1000.0;
+}
+
+double EnergyMeter::getWindowAvgPowerW(const std::string& uuid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(uuid);
+    if (it == entries_.end() || it->second.window.size() < 2) return 0.0;
+    const auto& first = it->second.window.front();
+    const auto& last = it->second.window.back();
+    double seconds = std::chrono::duration<double>(last.first - first.first).count();
+    return seconds > 0.0 ? (last.second - first.second) / 1000.0 / seconds : 0.0;
+}
+
+bool EnergyMeter::isExact(const std::string& uuid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(uuid);
+    return it != entries_.end() && it->second.exact;
+}
+
+void EnergyMeter::checkpoint(bool force) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    if (!force && now - lastCheckpoint_ < std::chrono::seconds(checkpointSec_)) return;
+    lastCheckpoint_ = now;
+
+    std::ostringstream content;
+    content.precision(17);
+    if (!bootId_.empty()) content << "boot_id " << bootId_ << "\n";
+    for (const auto& entry : entries_) {
+        content << entry.first << " " << entry.second.totalMj << " " << entry.second.lastRaw << "\n";
+    }
+
+    // Write, sync, then rename over the old file: a crash or a full disk leaves
+    // either the previous checkpoint or the complete new one, never a truncated file
+    std::string tmp = path_ + ".tmp";
+    std::string error = writeDurably(tmp, content.str());
+    if (error.empty() && std::rename(tmp.c_str(), path_.c_str()) != 0) error = std::string("rename: ") + std::strerror(errno);
+    if (error.empty()) {
+        syncDirectory(path_);
+        warned_ = false;
+        return;
+    }
+    std::remove(tmp.c_str());
+    if (!warned_) std::cerr << "[Energy] Cannot write checkpoint " << path_ << " (" << error << "), keeping the previous one" << std::endl;
+    warned_ = true;
+}
+
+std::string EnergyMeter::writeDurably(const std::string& path, const std::string& data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return std::string("open: ") + std::strerror(errno);
+    std::string error;
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error = std::string("write: ") + std::strerror(n < 0 ? errno : EIO);
+            break;
+        }
+        written += n;
+    }
+    if (error.empty() && ::fsync(fd) != 0) error = std::string("fsync: ") + std::strerror(errno);
+    if (::close(fd) != 0 && error.empty()) error = std::string("close: ") + std::strerror(errno);
+    return error;
+}
+
+void EnergyMeter::syncDirectory(const std::string& path) {
+    // Makes the rename itself durable
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace temper
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace temper {
+
+// Monotonic per-GPU energy accounting keyed by UUID.
+//
+// Fed from the driver's total-energy counter (mJ since driver load), which
+// captures spikes that 100ms power samples miss. Totals and the last raw
+// counter value are checkpointed to disk, so energy used while the daemon was
+// down is still counted after a restart. A counter that went backwards
+// (driver reload, reboot) contributes its full value as the delta, and so
+// does the first reading after a reboot (the checkpoint records the boot id),
+// since a new counter that already passed the old value would look like a
+// small delta.
+//
+// Configuration (environment):
+//   ENERGY_STATE_FILE      Checkpoint path (default /var/lib/temper/energy.state)
+//   ENERGY_CHECKPOINT_SEC  Checkpoint interval (default 60)
+//   ENERGY_WINDOW_SEC      Averaging window for derived power (default 10)
+class EnergyMeter {
+public:
+    EnergyMeter();
+
+    // Exact path: raw hardware counter in millijoules
+    void updateCounter(const std::string& uuid, unsigned long long counterMj);
+    // Fallback for GPUs without an energy counter: integrate power draw
+    void updatePower(const std::string& uuid, double powerMw);
+
+    double getJoules(const std::string& uuid) const;
+    double getWindowAvgPowerW(const std::string& uuid) const;
+    bool isExact(const std::string& uuid) const;
+    unsigned int getWindowSec() const { return windowSec_; }
+
+    // Writes the checkpoint if the interval has elapsed (or always when forced)
+    void checkpoint(bool force = false);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        double totalMj = 0.0;
+        unsigned long long lastRaw = 0;
+        bool haveRaw = false;
+        bool exact = false;
+        Clock::time_point lastUpdate;
+        std::deque<std::pair<Clock::time_point, double>> window; // (time, totalMj)
+    };
+
+    void load();
+    void record(Entry& e, Clock::time_point now);
+    // Empty on success, else what failed
+    static std::string writeDurably(const std::string& path, const std::string& data);
+    static void syncDirectory(const std::string& path);
+
+    std::map<std::string, Entry> entries_;
+    std::string path_ = "/var/lib/temper/energy.state";
+    std::string bootId_; // Empty if the kernel doesn't expose one
+    unsigned int checkpointSec_ = 60;
+    unsigned int windowSec_ = 10;
+    Clock::time_point lastCheckpoint_;
+    bool warned_ = false;
+    mutable std::mutex mutex_;
+};
+
+} // namespace temper
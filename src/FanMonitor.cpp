@@ -0,0 +1,67 @@
+#include "FanMonitor.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace temper {
+
+FanMonitor::FanMonitor() {
+    const char* tEnv = std::getenv("FAN_STALL_TOLERANCE");
+    if (tEnv) tolerance_ = std::min(100ul, std::strtoul(tEnv, nullptr, 10));
+
+    const char* sEnv = std::getenv("FAN_STALL_SEC");
+    if (sEnv) stallAfter_ = std::chrono::seconds(std::strtoul(sEnv, nullptr, 10));
+}
+
+bool FanMonitor::update(unsigned int device, unsigned int fan, unsigned int commanded, const GpuBackend::FanInfo& info) {
+    State* entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry = &states_[{device, fan}];
+    }
+    State& s = *entry;
+    auto now = Clock::now();
+
+    // The driver clamps commands to the fan's supported range, so its target is the better reference
+    bool haveTarget = (info.valid & GpuBackend::FAN_TARGET) && info.target > 0;
+    unsigned int expected = std::min(100u, haveTarget ? info.target : commanded);
+    if (expected > s.settleSpeed + SETTLE_BAND || expected + SETTLE_BAND < s.settleSpeed) {
+        s.settleSpeed = expected;
+        s.settleSince = now;
+    }
+
+    bool mismatch = false;
+    if (expected > 0 && (info.valid & GpuBackend::FAN_RPM)) {
+        double& reference = s.rpmPerPercent[expected / 10];
+        double floorRpm = reference * expected * (100 - tolerance_) / 100.0;
+        mismatch = info.rpm == 0 || info.rpm < floorRpm;
+        bool settled = now - s.settleSince >= SETTLE_TIME;
+        if (!mismatch && settled) reference = std::max(reference, (double)info.rpm / expected);
+    } else if (expected > 0 && (info.valid & GpuBackend::FAN_SPEED)) {
+        mismatch = info.speed == 0;
+    }
+
+    if (!mismatch) {
+        if (s.stalled) {
+            std::cout << "[Fan] GPU " << device << " fan " << fan << " recovered" << std::endl;
+        }
+        s.mismatch = false;
+        s.stalled = false;
+        return false;
+    }
+
+    if (!s.mismatch) {
+        s.mismatch = true;
+        s.mismatchSince = now;
+    }
+    if (!s.stalled && now - s.mismatchSince >= stallAfter_) {
+        s.stalled = true;
+        std::cerr << "[Fan] GPU " << device << " fan " << fan << " stalled: commanded " << commanded << "%";
+        if (info.valid & GpuBackend::FAN_SPEED) std::cerr << ", reported " << info.speed << "%";
+        if (info.valid & GpuBackend::FAN_RPM) std::cerr << " / " << info.rpm << " RPM";
+        std::cerr << std::endl;
+    }
+    return s.stalled;
+}
+
+} // namespace temper
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GpuBackend.hpp"
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace temper {
+
+// Flags fans whose tachometer doesn't follow what they were asked to do.
+//
+// The reported speed % is the driver's intended speed, not a measurement, so
+// only the RPM reading can show a fan that spins too slowly. A fan is stalled
+// when, for FAN_STALL_SEC seconds (default 10), it reads 0 RPM while it
+// should spin, or reads more than FAN_STALL_TOLERANCE % (default 20) below
+// the RPM it reached at the same speed earlier. That reference is learned per
+// fan and per 10% band of speed, from readings taken once the speed has held
+// steady for a few seconds without a fault, and only grows; until a band has
+// one, only 0 RPM is flagged.
+//
+// Fans without a tachometer can only be flagged on a full stop, when the
+// driver itself reports 0% while a non-zero speed is expected.
+class FanMonitor {
+public:
+    FanMonitor();
+
+    // commanded: what we wrote (% of max); returns true while the fan is stalled
+    bool update(unsigned int device, unsigned int fan, unsigned int commanded, const GpuBackend::FanInfo& info);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static const unsigned int BANDS = 11;  // 0-9%, 10-19%, ... 100%
+    static const unsigned int SETTLE_BAND = 2; // % the expected speed may wander while settling
+    static constexpr std::chrono::seconds SETTLE_TIME{5};
+
+    struct State {
+        bool mismatch = false;
+        bool stalled = false;
+        Clock::time_point mismatchSince;
+        unsigned int settleSpeed = 0;      // Expected speed the fan is settling at
+        Clock::time_point settleSince;
+        std::array<double, BANDS> rpmPerPercent{}; // Learned reference, 0 until seen
+    };
+
+    std::mutex mutex_; // Guards the map only; each entry belongs to one device's telemetry worker
+    std::map<std::pair<unsigned int, unsigned int>, State> states_;
+    unsigned int tolerance_ = 20;
+    Clock::duration stallAfter_ = std::chrono::seconds(10);
+};
+
+} // namespace temper
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "Common.hpp"
+#include <nvml.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace temper {
+
+// Failed driver call, with the NVML return code it failed with
+class BackendError : public std::runtime_error {
+public:
+    BackendError(const std::string& what, nvmlReturn_t code) : std::runtime_error(what), code_(code) {}
+
+    nvmlReturn_t code() const { return code_; }
+    // Retrying can't help: the device lacks the feature or the process the privilege
+    bool isPermanent() const { return code_ == NVML_ERROR_NOT_SUPPORTED || code_ == NVML_ERROR_NO_PERMISSION; }
+
+private:
+    nvmlReturn_t code_;
+};
+
+// Device access interface used by the control loop. NVMLManager drives real
+// hardware; SimulatedBackend models it so the loop can run without a driver.
+class GpuBackend {
+public:
+    virtual ~GpuBackend() = default;
+
+    // Per-device query support, probed once; unsupported queries are never issued again
+    enum Capability : unsigned int {
+        CAP_TEMPERATURE = 1u << 0,
+        CAP_POWER_USAGE = 1u << 1,
+        CAP_POWER_LIMIT = 1u << 2,
+        CAP_UTILIZATION = 1u << 3,
+        CAP_MEMORY      = 1u << 4,
+        CAP_THROTTLE    = 1u << 5,
+        CAP_ECC         = 1u << 6,
+        CAP_MEMORY_TEMP = 1u << 7,
+    };
+
+    // Per-tick core readings; `valid` holds the CAP_* bits that were read this tick
+    struct CoreReadings {
+        unsigned int valid = 0;
+        unsigned int temperature = 0;      // C
+        unsigned int powerUsage = 0;       // mW
+        unsigned int powerLimit = 0;       // mW
+        unsigned int utilGpu = 0;          // %
+        unsigned int utilMem = 0;          // %
+        unsigned long long memTotal = 0;   // Bytes
+        unsigned long long memUsed = 0;    // Bytes
+        unsigned long long throttleReasons = 0;
+    };
+
+    struct Clocks {
+        unsigned int graphics = 0;
+        unsigned int memory = 0;
+        unsigned int sm = 0;
+        unsigned int video = 0;
+        unsigned int maxGraphics = 0;
+        unsigned int maxMemory = 0;
+        unsigned int maxSm = 0;
+        unsigned int maxVideo = 0;
+    };
+    
+    struct PcieInfo {
+        unsigned int txThroughput = 0; // KB/s
+        unsigned int rxThroughput = 0; // KB/s
+        unsigned int gen = 0;
+        unsigned int width = 0;
+        unsigned int maxGen = 0;   // Best the GPU and slot can negotiate
+        unsigned int maxWidth = 0;
+        bool replaySupported = false;
+        unsigned int replayCounter = 0; // Cumulative link-level retransmissions
+    };
+
+    struct EccCounts {
+        unsigned long long volatileSingle = 0;
+        unsigned long long volatileDouble = 0;
+        unsigned long long aggregateSingle = 0;
+        unsigned long long aggregateDouble = 0;
+    };
+
+    struct ProcessInfo {
+        unsigned int pid = 0;
+        unsigned long long usedMemory = 0; // Bytes
+        std::string name = "";
+        std::string cmdline = "";
+        unsigned int smUtil = 0;  // %
+        unsigned int memUtil = 0; // %
+        unsigned int encUtil = 0; // %
+        unsigned int decUtil = 0; // %
+        unsigned int gpuInstanceId = 0xFFFFFFFF;     // MIG slice, 0xFFFFFFFF if not MIG
+        unsigned int computeInstanceId = 0xFFFFFFFF;
+    };
+
+    struct MigComputeInstance {
+        unsigned int id = 0;
+        std::string uuid;
+        unsigned int sliceCount = 0;
+        unsigned int multiprocessorCount = 0;
+    };
+
+    struct MigGpuInstance {
+        unsigned int id = 0;
+        unsigned int sliceCount = 0;
+        unsigned long long memTotal = 0; // Bytes
+        unsigned long long memUsed = 0;  // Bytes
+        bool utilSupported = false;      // Needs GPM (Hopper and newer)
+        double smUtil = 0.0;             // %
+        double memBwUtil = 0.0;          // %
+        std::vector<MigComputeInstance> computeInstances;
+    };
+
+    // Per-fan readings, each probed like the device capabilities
+    enum FanField : unsigned int {
+        FAN_SPEED  = 1u << 0,
+        FAN_TARGET = 1u << 1,
+        FAN_POLICY = 1u << 2,
+        FAN_RPM    = 1u << 3,
+    };
+
+    struct FanInfo {
+        unsigned int valid = 0;  // FAN_* bits read this call; the others are 0
+        unsigned int speed = 0;  // % reported by the driver
+        unsigned int target = 0; // % the driver is steering towards
+        unsigned int policy = 0; // NVML_FAN_POLICY_*
+        unsigned int rpm = 0;
+    };
+
+    // Per-link counters are cumulative; rates cover the interval since the previous call
+    struct NvLinkInfo {
+        unsigned int link = 0;
+        unsigned int version = 0;
+        bool active = false;       // Re-read on every call; rates are 0 while down
+        std::string remoteBusId;
+        unsigned long long txKiB = 0;
+        unsigned long long rxKiB = 0;
+        unsigned long long crcFlitErrors = 0;
+        unsigned long long crcDataErrors = 0;
+        unsigned long long replayErrors = 0;
+        unsigned long long recoveryErrors = 0;
+        double txKBps = 0.0;
+        double rxKBps = 0.0;
+        double errorsPerSec = 0.0; // CRC + replay + recovery
+    };
+
+    // Cumulative time each limiter held clocks below the requested level, ns since driver load
+    struct ViolationTimes {
+        bool supported = false;
+        unsigned long long powerNs = 0;
+        unsigned long long thermalNs = 0;
+        unsigned long long syncBoostNs = 0;
+        unsigned long long reliabilityNs = 0;
+    };
+
+    // Aggregate of the driver samples collected since the previous drain
+    struct SampleWindow {
+        unsigned int count = 0;
+        unsigned int nonZero = 0; // Samples above zero; for utilization, the busy ones
+        double average = 0.0;
+        double peak = 0.0;
+    };
+
+    struct SampleWindows {
+        SampleWindow gpuUtil; // %
+        SampleWindow memUtil; // %
+        SampleWindow power;   // mW
+    };
+
+    virtual unsigned int getDeviceCount() const = 0;
+    virtual nvmlDevice_t getHandle(unsigned int index) const = 0;
+    virtual std::string getUUID(nvmlDevice_t handle) const = 0;
+
+    // CAP_* bits; probes on first call per device
+    virtual unsigned int getCapabilities(nvmlDevice_t handle) const = 0;
+    // Exception-free hot path for the control loop, reading only the `wanted`
+    // CAP_* bits. Failed or unsupported reads leave their bit clear in `valid`;
+    // a query the driver reports as unsupported at runtime is dropped from the
+    // device's capabilities.
+    virtual CoreReadings readCore(nvmlDevice_t handle, unsigned int wanted) const = 0;
+
+    virtual unsigned int getTemperature(nvmlDevice_t handle) const = 0;
+    virtual unsigned int getFanSpeed(nvmlDevice_t handle) const = 0; // Fan 0
+    // A field the driver reports as unsupported for a fan is not queried again
+    virtual std::vector<FanInfo> getFans(nvmlDevice_t handle) const = 0;
+    virtual unsigned int getPowerUsage(nvmlDevice_t handle) const = 0;
+    virtual unsigned int getPowerLimit(nvmlDevice_t handle) const = 0;
+    virtual void getUtilization(nvmlDevice_t handle, unsigned int& gpu, unsigned int& memory) const = 0;
+    virtual void getMemoryInfo(nvmlDevice_t handle, unsigned long long& total, unsigned long long& used) const = 0;
+    virtual std::string getName(nvmlDevice_t handle) const = 0;
+
+    // Advanced Metrics
+    virtual Clocks getClocks(nvmlDevice_t handle) const = 0;
+    virtual PcieInfo getPcieInfo(nvmlDevice_t handle) const = 0;
+    virtual EccCounts getEccCounts(nvmlDevice_t handle) const = 0;
+    virtual std::vector<ProcessInfo> getProcesses(nvmlDevice_t handle) const = 0;
+    virtual std::string getVbiosVersion(nvmlDevice_t handle) const = 0;
+    virtual std::string getSerial(nvmlDevice_t handle) const = 0;
+    virtual unsigned int getPowerState(nvmlDevice_t handle) const = 0; // P-State
+
+    // Sub-tick samples from the driver's ring buffers. Backends without them
+    // return empty windows and callers fall back to the point readings.
+    virtual SampleWindows drainSamples(nvmlDevice_t) const { return SampleWindows(); }
+
+    // Total energy since driver load in mJ; false if the GPU has no energy counter
+    virtual bool getEnergyConsumption(nvmlDevice_t, unsigned long long&) const { return false; }
+
+    // Throttle time counters; unsupported on older boards (callers fall back to the reason bitmask)
+    virtual ViolationTimes getViolationTimes(nvmlDevice_t) const { return ViolationTimes(); }
+
+    // Memory (HBM / GDDR6X junction) temperature in C; false where the board doesn't
+    // expose it (CAP_MEMORY_TEMP clear, and then not queried)
+    virtual bool getMemoryTemperature(nvmlDevice_t, unsigned int&) const { return false; }
+
+    // Core temperature (C) at which the GPU starts thermal slowdown; false if not reported
+    virtual bool getSlowdownTemperature(nvmlDevice_t, unsigned int&) const { return false; }
+
+    // NVLink topology and counters; empty on GPUs without NVLink
+    virtual std::vector<NvLinkInfo> getNvLinks(nvmlDevice_t) const { return {}; }
+
+    // MIG partitions of a physical GPU; empty when MIG is disabled or unsupported
+    virtual std::vector<MigGpuInstance> getMigInstances(nvmlDevice_t) const { return {}; }
+
+    virtual unsigned int getNumFans(nvmlDevice_t handle) const = 0;
+    virtual void setFanSpeed(nvmlDevice_t handle, unsigned int fan, unsigned int speedPercent) = 0;
+    virtual void setPowerLimit(nvmlDevice_t handle, unsigned int watts) = 0;
+    virtual void getPowerConstraints(nvmlDevice_t handle, unsigned int& minW, unsigned int& maxW) const = 0;
+    virtual void restoreAutoFans(nvmlDevice_t handle) = 0;
+    // Locked clock ranges in MHz (min == max pins the clock); reset returns both to driver control
+    virtual void setGpuLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) = 0;
+    virtual void setMemoryLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) = 0;
+    virtual void resetLockedClocks(nvmlDevice_t handle) = 0;
+    virtual unsigned long long getThrottleReasons(nvmlDevice_t handle) const = 0;
+};
+
+} // namespace temper
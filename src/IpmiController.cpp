@@ -106,6 +106,9 @@ void IpmiController::startAsyncPoll() {
 
     // Start new polling thread
     pollingThread_ = std::make_unique<std::thread>([this]() {
+        // Shutdown is handled on the main thread; started by the loop, which may be pinned
+        blockShutdownSignals();
+        resetThreadAffinity();
         pollMetricsImpl();
     });
 }
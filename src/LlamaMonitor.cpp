@@ -62,6 +62,9 @@ LlamaMetrics LlamaMonitor::getMetrics() const {
 }
 
 void LlamaMonitor::pollLoop() {
+    // Shutdown is handled on the main thread
+    blockShutdownSignals();
+
     while (running_) {
         checkStatus();
         // Poll at 10Hz to match NVML and llama.cpp --poll 100
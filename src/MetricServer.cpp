@@ -1,9 +1,14 @@
 #include "MetricServer.hpp"
+#include "ProcessUtils.hpp"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <thread>
 #include <algorithm>
@@ -31,13 +36,59 @@ void MetricServer::stop() {
 }
 
 // Update with LlamaMetrics
-void MetricServer::updateMetrics(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama) {
-    std::string json = buildJson(metrics, host, ipmi, llama);
+void MetricServer::updateMetrics(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama, const PowerBudgetMetrics& budget, const ConfigStatus& config, const LoopStats& loop, const RealtimeStatus& realtime) {
+    std::string json = buildJson(metrics, host, ipmi, llama, budget, config, loop, realtime);
     std::lock_guard<std::mutex> lock(m_mutex);
     m_cachedJson = json;
 }
 
-std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama) {
+template <typename T>
+void MetricServer::writeOptional(std::ostream& oss, bool present, T value) {
+    if (present) oss << value;
+    else oss << "null";
+}
+
+std::string MetricServer::escapeJson(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) out += ' ';
+                else out += c;
+        }
+    }
+    return out;
+}
+
+void MetricServer::writeProcesses(std::ostream& oss, const std::vector<ProcessInfo>& processes) {
+    oss << "[";
+    for (size_t j = 0; j < processes.size(); ++j) {
+        oss << "{"
+            << "\"pid\":" << processes[j].pid << ","
+            << "\"name\":\"" << escapeJson(processes[j].name) << "\","
+            << "\"cmdline\":\"" << escapeJson(processes[j].cmdline) << "\","
+            << "\"used_memory\":" << processes[j].usedMemory << ","
+            << "\"sm_util_percent\":" << processes[j].smUtil << ","
+            << "\"mem_util_percent\":" << processes[j].memUtil << ","
+            << "\"enc_util_percent\":" << processes[j].encUtil << ","
+            << "\"dec_util_percent\":" << processes[j].decUtil
+            << "}";
+        if (j < processes.size() - 1) oss << ",";
+    }
+    oss << "]";
+}
+
+void MetricServer::setConfigHandler(ConfigHandler handler) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_configHandler = std::move(handler);
+}
+
+std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama, const PowerBudgetMetrics& budget, const ConfigStatus& config, const LoopStats& loop, const RealtimeStatus& realtime) {
     std::stringstream oss;
     oss << "{"
         << "\"host\": {"
@@ -150,6 +201,67 @@ std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, cons
     }
     oss << "},";
 
+    oss << "\"config\": {"
+            << "\"generation\":" << config.generation << ","
+            << "\"source\":\"" << escapeJson(config.source) << "\","
+            << "\"applied_at\":" << std::fixed << std::setprecision(3) << config.appliedAt << std::defaultfloat << std::setprecision(6) << ","
+            << "\"file\":\"" << escapeJson(config.file) << "\","
+            << "\"rejected\":" << config.rejected << ","
+            << "\"last_error\":\"" << escapeJson(config.lastError) << "\""
+        << "},";
+
+    oss << "\"control_loop\": {"
+            << "\"period_ms\":" << loop.periodMs << ","
+            << "\"tick\":" << loop.tick << ","
+            << "\"tick_time\":" << std::fixed << std::setprecision(3) << loop.tickTime << std::defaultfloat << std::setprecision(6) << ","
+            << "\"ticks\":" << loop.ticks << ","
+            << "\"overruns\":" << loop.overruns << ","
+            << "\"skipped_ticks\":" << loop.skipped << ","
+            << "\"wake_latency_ms\": {"
+                << "\"avg\":" << loop.wakeAvgMs << ","
+                << "\"p99\":" << loop.wakeP99Ms << ","
+                << "\"max\":" << loop.wakeMaxMs
+            << "},"
+            << "\"period_jitter_ms\": {"
+                << "\"rms\":" << loop.jitterRmsMs << ","
+                << "\"max\":" << loop.jitterMaxMs
+            << "},"
+            << "\"work_ms\": {"
+                << "\"avg\":" << loop.workAvgMs << ","
+                << "\"max\":" << loop.workMaxMs
+            << "},"
+            << "\"realtime\": {"
+                << "\"requested\":" << (realtime.requested ? "true" : "false") << ","
+                << "\"active\":" << (realtime.active ? "true" : "false") << ","
+                << "\"priority\":" << realtime.priority << ","
+                << "\"worker_priority\":" << realtime.workerPriority << ","
+                << "\"cpu\":";
+    writeOptional(oss, realtime.cpu >= 0, realtime.cpu);
+    oss << ",\"memory_locked\":" << (realtime.memoryLocked ? "true" : "false") << ","
+                << "\"threads\":" << realtime.threads << ","
+                << "\"probe_avg_ms\":" << realtime.probeAvgMs << ","
+                << "\"probe_max_ms\":" << realtime.probeMaxMs << ","
+                << "\"error\":\"" << escapeJson(realtime.error) << "\""
+            << "}"
+        << "},";
+
+    oss << "\"power_budget\": {"
+            << "\"enabled\":" << (budget.enabled ? "true" : "false");
+    if (budget.enabled) {
+        oss << ",\"budget_w\":" << budget.budgetW << ","
+            << "\"node_power_w\":" << budget.nodePowerW << ","
+            << "\"chassis_measured\":" << (budget.chassisMeasured ? "true" : "false") << ","
+            << "\"gpu_budget_w\":" << budget.gpuBudgetW << ","
+            << "\"allocated_w\":" << budget.allocatedW << ","
+            << "\"feasible\":" << (budget.feasible ? "true" : "false") << ","
+            << "\"overshoot_w\":" << budget.overshootW << ","
+            << "\"peak_overshoot_w\":" << budget.peakOvershootW << ","
+            << "\"overshoot_seconds\":" << budget.overshootSeconds << ","
+            << "\"overshoot_events\":" << budget.overshootEvents << ","
+            << "\"last_settle_seconds\":" << budget.lastSettleSec;
+    }
+    oss << "},";
+
     oss << "\"gpus\": [";
     for (size_t i = 0; i < metrics.size(); ++i) {
         const auto& m = metrics[i];
@@ -158,19 +270,104 @@ std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, cons
             << "\"name\":\"" << m.name << "\","
             << "\"serial\":\"" << m.serial << "\","
             << "\"vbios\":\"" << m.vbios << "\","
+
+            << "\"health\": {"
+                << "\"responsive\":" << (m.responsive ? "true" : "false") << ","
+                << "\"stale_seconds\":" << m.staleSeconds << ","
+                << "\"hang_events\":" << m.hangEvents
+            << "},"
+
+            << "\"telemetry_age_seconds\": {"
+                << "\"samples\":";
+        writeOptional(oss, m.samplesAgeSec >= 0, m.samplesAgeSec);
+        oss << ",\"links\":";
+        writeOptional(oss, m.linksAgeSec >= 0, m.linksAgeSec);
+        oss << ",\"ecc\":";
+        writeOptional(oss, m.eccAgeSec >= 0, m.eccAgeSec);
+        oss << ",\"processes\":";
+        writeOptional(oss, m.processesAgeSec >= 0, m.processesAgeSec);
+        oss << "},"
+            << "\"temperature\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_TEMPERATURE, m.temp);
+        oss << ",";
+        if (m.memTempSupported) oss << "\"memory_temperature\":" << m.memTemp << ",";
+        else oss << "\"memory_temperature\":null,";
+        oss << "\"control_temperature\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_TEMPERATURE, m.controlTemp);
+        oss << ",\"curve_temperature\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_TEMPERATURE, m.curveTemp);
+        oss << ","
+            << "\"control_sensor\":\"" << m.controlSensor << "\","
+            << "\"fan_speed_percent\":";
+        writeOptional(oss, !m.fans.empty() && (m.fans[0].valid & GpuBackend::FAN_SPEED), m.fanSpeed);
+        oss << ","
+            << "\"target_fan_percent\":" << m.targetFan << ",";
+        if (m.fanPid.enabled) {
+            oss << "\"fan_control\": {"
+                << "\"mode\":\"pid\","
+                << "\"rule\":\"" << escapeJson(m.fanCurveRule) << "\","
+                << "\"target\":" << m.fanPid.target << ","
+                << "\"error\":" << m.fanPid.error << ","
+                << "\"integral\":" << m.fanPid.integral << ","
+                << "\"output\":" << m.fanPid.output
+                << "},";
+        } else {
+            oss << "\"fan_control\": {\"mode\":\"curve\",\"rule\":\"" << escapeJson(m.fanCurveRule) << "\"},";
+        }
+        oss << "\"fans\": [";
+            for (size_t j = 0; j < m.fans.size(); ++j) {
+                const auto& f = m.fans[j];
+                oss << "{"
+                    << "\"index\":" << f.index << ","
+                    << "\"speed_percent\":";
+                writeOptional(oss, f.valid & GpuBackend::FAN_SPEED, f.speed);
+                oss << ",\"target_percent\":";
+                writeOptional(oss, f.valid & GpuBackend::FAN_TARGET, f.target);
+                oss << ",\"commanded_percent\":" << f.commanded << ","
+                    << "\"rpm\":";
+                writeOptional(oss, f.valid & GpuBackend::FAN_RPM, f.rpm);
+                oss << ",\"policy\":";
+                if (f.valid & GpuBackend::FAN_POLICY) oss << "\"" << (f.manual ? "manual" : "auto") << "\"";
+                else oss << "null";
+                oss << ",\"stalled\":" << (f.stalled ? "true" : "false")
+                    << "}";
+                if (j < m.fans.size() - 1) oss << ",";
+            }
+        oss << "],"
             
-            << "\"temperature\":" << m.temp << ","
-            << "\"fan_speed_percent\":" << m.fanSpeed << ","
-            << "\"target_fan_percent\":" << m.targetFan << ","
-            
-            << "\"power_usage_mw\":" << m.powerUsage << ","
-            << "\"power_limit_mw\":" << m.powerLimit << ","
+            << "\"power_usage_mw\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_POWER_USAGE, m.powerUsage);
+        oss << ",\"power_limit_mw\":";
+        writeOptional(oss, m.powerLimit > 0, m.powerLimit);
+        oss << ","
+
+            << "\"energy\": {"
+                << "\"total_joules\":" << std::fixed << std::setprecision(3) << m.energyJoules << std::defaultfloat << std::setprecision(6) << ","
+                << "\"window_avg_power_w\":" << m.energyAvgPowerW << ","
+                << "\"window_sec\":" << m.energyWindowSec << ","
+                << "\"source\":\"" << (m.energyExact ? "counter" : "integrated") << "\""
+            << "},"
             
             << "\"resources\": {"
-                << "\"gpu_load_percent\":" << m.utilGpu << ","
-                << "\"memory_load_percent\":" << m.utilMem << ","
-                << "\"memory_used_mb\":" << (m.memUsed / 1024 / 1024) << ","
-                << "\"memory_total_mb\":" << (m.memTotal / 1024 / 1024)
+                << "\"gpu_load_percent\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_UTILIZATION, m.utilGpu);
+        oss << ",\"memory_load_percent\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_UTILIZATION, m.utilMem);
+        oss << ",\"memory_used_mb\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_MEMORY, m.memUsed / 1024 / 1024);
+        oss << ",\"memory_total_mb\":";
+        writeOptional(oss, m.present & GpuBackend::CAP_MEMORY, m.memTotal / 1024 / 1024);
+        oss << "},"
+
+            << "\"samples\": {"
+                << "\"count\":" << m.sampleCount << ","
+                << "\"gpu_load_avg_percent\":" << m.utilGpuAvg << ","
+                << "\"gpu_load_peak_percent\":" << m.utilGpuPeak << ","
+                << "\"memory_load_avg_percent\":" << m.utilMemAvg << ","
+                << "\"memory_load_peak_percent\":" << m.utilMemPeak << ","
+                << "\"power_avg_mw\":" << m.powerAvg << ","
+                << "\"power_peak_mw\":" << m.powerPeak << ","
+                << "\"duty_cycle_percent\":" << m.dutyCycle
             << "},"
 
              << "\"p_state\": {"
@@ -186,36 +383,155 @@ std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, cons
                 << "\"max_graphics\":" << m.maxClockGraphics << ","
                 << "\"max_memory\":" << m.maxClockMemory << ","
                 << "\"max_sm\":" << m.maxClockSm << ","
-                << "\"max_video\":" << m.maxClockVideo
-            << "},"
+                << "\"max_video\":" << m.maxClockVideo << ",";
+        // Lock targets next to the achieved clocks above
+        if (m.lockedClockGraphics) oss << "\"locked_graphics\":" << m.lockedClockGraphics << ",";
+        else oss << "\"locked_graphics\":null,";
+        if (m.lockedClockMemory) oss << "\"locked_memory\":" << m.lockedClockMemory;
+        else oss << "\"locked_memory\":null";
+        oss << "},"
             
             << "\"pcie\": {"
                 << "\"tx_throughput_kbs\":" << m.pcieTx << ","
                 << "\"rx_throughput_kbs\":" << m.pcieRx << ","
                 << "\"gen\":" << m.pcieGen << ","
-                << "\"width\":" << m.pcieWidth
+                << "\"width\":" << m.pcieWidth << ","
+                << "\"max_gen\":" << m.pcieMaxGen << ","
+                << "\"max_width\":" << m.pcieMaxWidth << ",";
+        if (m.pcieReplaySupported) oss << "\"replay_counter\":" << m.pcieReplayCounter << ",";
+        else oss << "\"replay_counter\":null,";
+        oss << "\"replays_per_sec\":" << m.pcieReplaysPerSec << ","
+                << "\"degraded\":" << (m.pcieDegraded ? "true" : "false") << ","
+                << "\"degraded_events\":" << m.pcieDegradedEvents
             << "},"
 
-            << "\"ecc\": {"
+            << "\"nvlink\": {"
+                << "\"tx_throughput_kbs\":" << m.nvlinkTxKBps << ","
+                << "\"rx_throughput_kbs\":" << m.nvlinkRxKBps << ","
+                << "\"links\": [";
+            for (size_t j = 0; j < m.nvlinks.size(); ++j) {
+                const auto& l = m.nvlinks[j];
+                oss << "{"
+                    << "\"link\":" << l.link << ","
+                    << "\"active\":" << (l.active ? "true" : "false") << ","
+                    << "\"version\":" << l.version << ","
+                    << "\"remote_bus_id\":\"" << l.remoteBusId << "\","
+                    << "\"tx_throughput_kbs\":" << l.txKBps << ","
+                    << "\"rx_throughput_kbs\":" << l.rxKBps << ","
+                    << "\"crc_flit_errors\":" << l.crcFlitErrors << ","
+                    << "\"crc_data_errors\":" << l.crcDataErrors << ","
+                    << "\"replay_errors\":" << l.replayErrors << ","
+                    << "\"recovery_errors\":" << l.recoveryErrors << ","
+                    << "\"errors_per_sec\":" << l.errorsPerSec
+                    << "}";
+                if (j < m.nvlinks.size() - 1) oss << ",";
+            }
+        oss << "]},"
+
+            << "\"ecc\": ";
+        if (m.present & GpuBackend::CAP_ECC) {
+            oss << "{"
                 << "\"volatile_single\":" << m.eccVolatileSingle << ","
                 << "\"volatile_double\":" << m.eccVolatileDouble << ","
                 << "\"aggregate_single\":" << m.eccAggregateSingle << ","
                 << "\"aggregate_double\":" << m.eccAggregateDouble
-            << "},"
+            << "}";
+        } else {
+            oss << "null";
+        }
+        oss << ","
 
-            << "\"processes\": [";
-            for (size_t j = 0; j < m.processes.size(); ++j) {
+            << "\"processes\": ";
+        writeProcesses(oss, m.processes);
+        oss << ","
+
+            << "\"mig_instances\": [";
+            for (size_t j = 0; j < m.migInstances.size(); ++j) {
+                const auto& gi = m.migInstances[j];
                 oss << "{"
-                    << "\"pid\":" << m.processes[j].pid << ","
-                    << "\"name\":\"" << m.processes[j].name << "\","
-                    << "\"used_memory\":" << m.processes[j].usedMemory
-                    << "}";
-                if (j < m.processes.size() - 1) oss << ",";
+                    << "\"gpu_instance_id\":" << gi.id << ","
+                    << "\"slices\":" << gi.sliceCount << ","
+                    << "\"memory_used_mb\":" << (gi.memUsed / 1024 / 1024) << ","
+                    << "\"memory_total_mb\":" << (gi.memTotal / 1024 / 1024) << ",";
+                if (gi.utilSupported) {
+                    oss << "\"sm_util_percent\":" << gi.smUtil << ","
+                        << "\"dram_bw_util_percent\":" << gi.memBwUtil << ",";
+                } else {
+                    oss << "\"sm_util_percent\":null,"
+                        << "\"dram_bw_util_percent\":null,";
+                }
+                oss << "\"compute_instances\": [";
+                for (size_t k = 0; k < gi.computeInstances.size(); ++k) {
+                    const auto& ci = gi.computeInstances[k];
+                    oss << "{"
+                        << "\"compute_instance_id\":" << ci.id << ","
+                        << "\"uuid\":\"" << ci.uuid << "\","
+                        << "\"slices\":" << ci.sliceCount << ","
+                        << "\"multiprocessor_count\":" << ci.multiprocessorCount << ","
+                        << "\"processes\": ";
+                    writeProcesses(oss, ci.processes);
+                    oss << "}";
+                    if (k < gi.computeInstances.size() - 1) oss << ",";
+                }
+                oss << "]}";
+                if (j < m.migInstances.size() - 1) oss << ",";
             }
         oss << "],"
 
+            << "\"actuation\": {"
+                << "\"fan_writes\":" << m.fanWrites << ","
+                << "\"fan_writes_suppressed\":" << m.fanWritesSuppressed << ","
+                << "\"power_writes\":" << m.powerWrites << ","
+                << "\"power_writes_suppressed\":" << m.powerWritesSuppressed << ","
+                << "\"clock_writes\":" << m.clockWrites << ","
+                << "\"clock_writes_suppressed\":" << m.clockWritesSuppressed << ","
+                << "\"errors\":" << m.actuationErrors
+            << "},"
+
+            << "\"smoothing\": {"
+                << "\"fan_changes\":" << m.smoothing.fanChanges << ","
+                << "\"fan_changes_unfiltered\":" << m.smoothing.fanChangesRaw << ","
+                << "\"power_changes\":" << m.smoothing.powerChanges << ","
+                << "\"power_changes_unfiltered\":" << m.smoothing.powerChangesRaw << ","
+                << "\"throttle_blips_ignored\":" << m.smoothing.throttleBlipsIgnored
+            << "},"
+
             << "\"throttle_alert\":\"" << m.throttleAlert << "\","
-            << "\"throttle_reason_bitmask\":" << m.throttleReasonsBitmask
+            << "\"throttle_reason_bitmask\":" << m.throttleReasonsBitmask << ","
+
+            << "\"thermal_model\": {"
+                << "\"ready\":" << (m.thermal.ready ? "true" : "false") << ","
+                << "\"samples\":" << m.thermal.samples << ","
+                << "\"horizon_s\":" << m.thermal.horizonSec << ","
+                << "\"time_constant_s\":";
+        writeOptional(oss, m.thermal.ready, m.thermal.timeConstantSec);
+        oss << ",\"steady_state_c\":";
+        writeOptional(oss, m.thermal.ready, m.thermal.steadyStateC);
+        oss << ",\"predicted_c\":";
+        writeOptional(oss, m.thermal.ready, m.thermal.predictedC);
+        oss << ",\"time_to_throttle_s\":";
+        writeOptional(oss, m.thermal.ready && m.thermal.timeToThrottleSec >= 0.0, m.thermal.timeToThrottleSec);
+        oss << ",\"prediction_error_c\":" << m.thermal.lastErrorC << ","
+            << "\"mean_abs_error_c\":" << m.thermal.meanAbsErrorC
+            << "},"
+
+            << "\"throttle_time\": {"
+                << "\"exact\":" << (m.throttle.exact ? "true" : "false") << ","
+                << "\"power_seconds\":" << m.throttle.powerSec << ","
+                << "\"thermal_seconds\":" << m.throttle.thermalSec << ","
+                << "\"sync_boost_seconds\":" << m.throttle.syncBoostSec << ","
+                << "\"reliability_seconds\":" << m.throttle.reliabilitySec << ","
+                << "\"busy_seconds\":" << m.throttle.busySec << ","
+                << "\"clock_deficit_percent\":" << m.throttle.clockDeficitPercent << ","
+                << "\"lost_seconds\": {"
+                    << "\"power\":" << m.throttle.lostPowerSec << ","
+                    << "\"thermal\":" << m.throttle.lostThermalSec << ","
+                    << "\"sync_boost\":" << m.throttle.lostSyncBoostSec << ","
+                    << "\"reliability\":" << m.throttle.lostReliabilitySec << ","
+                    << "\"other\":" << m.throttle.lostOtherSec << ","
+                    << "\"total\":" << m.throttle.lostTotalSec
+                << "}"
+            << "}"
             << "}";
         if (i < metrics.size() - 1) oss << ",";
     }
@@ -223,7 +539,76 @@ std::string MetricServer::buildJson(const std::vector<GpuMetrics>& metrics, cons
     return oss.str();
 }
 
+static std::string jsonResponse(const std::string& status, const std::string& body) {
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.length()) + "\r\n"
+           "Connection: close\r\n"
+           "\r\n" + body;
+}
+
+// Value of a header (name matched case-insensitively) in the request head, or empty
+static std::string headerValue(const std::string& head, const std::string& name) {
+    std::stringstream ss(head);
+    std::string line;
+    while (std::getline(ss, line)) {
+        auto colon = line.find(':');
+        if (colon == std::string::npos || colon != name.size()) continue;
+        if (!std::equal(name.begin(), name.end(), line.begin(),
+                        [](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); })) continue;
+        std::string value = line.substr(colon + 1);
+        size_t begin = value.find_first_not_of(" \t");
+        size_t end = value.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+    }
+    return "";
+}
+
+std::string MetricServer::handleConfig(int socket, const std::string& request) {
+    // Writes need their own key; the metrics key only grants reads
+    const char* envKey = std::getenv("CONFIG_API_KEY");
+    if (!envKey || !*envKey) return jsonResponse("404 Not Found", "{\"error\": \"Runtime config is disabled (CONFIG_API_KEY unset)\"}");
+
+    size_t headEnd = request.find("\r\n\r\n");
+    if (headEnd == std::string::npos) return jsonResponse("400 Bad Request", "{\"error\": \"Incomplete request\"}");
+    std::string head = request.substr(0, headEnd);
+    std::string key = envKey;
+    if (headerValue(head, "Authorization") != "Bearer " + key && headerValue(head, "X-API-Key") != key) {
+        return jsonResponse("401 Unauthorized", "{\"error\": \"Unauthorized\"}");
+    }
+
+    // Chunked or malformed bodies are refused: read as empty, they would revert the curves
+    constexpr size_t MAX_BODY = 65536;
+    std::string lengthHeader = headerValue(head, "Content-Length");
+    char* lengthEnd = nullptr;
+    errno = 0;
+    unsigned long length = std::strtoul(lengthHeader.c_str(), &lengthEnd, 10);
+    if (lengthHeader.empty() || !std::isdigit((unsigned char)lengthHeader[0]) || *lengthEnd || errno == ERANGE) {
+        return jsonResponse("411 Length Required", "{\"error\": \"Missing or invalid Content-Length\"}");
+    }
+    if (length > MAX_BODY) return jsonResponse("413 Payload Too Large", "{\"error\": \"Config too large\"}");
+    std::string body = request.substr(headEnd + 4);
+    char buffer[4096];
+    while (body.size() < length) {
+        ssize_t n = recv(socket, buffer, sizeof(buffer), 0);
+        if (n <= 0) return jsonResponse("400 Bad Request", "{\"error\": \"Body shorter than Content-Length\"}");
+        body.append(buffer, n);
+    }
+    body.resize(length);
+
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (!m_configHandler) return jsonResponse("503 Service Unavailable", "{\"error\": \"Control loop not running\"}");
+    std::string message;
+    if (!m_configHandler(body, message)) {
+        return jsonResponse("400 Bad Request", "{\"error\": \"" + escapeJson(message) + "\"}");
+    }
+    return jsonResponse("200 OK", "{\"status\": \"applied\", \"message\": \"" + escapeJson(message) + "\"}");
+}
+
 void MetricServer::loop() {
+    // Shutdown is handled on the main thread, which joins this one
+    blockShutdownSignals();
+
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd == 0) {
         std::cerr << "Socket creation failed" << std::endl;
@@ -268,11 +653,24 @@ void MetricServer::loop() {
             int new_socket = accept(server_fd, (struct sockaddr *)&address, &addrlen);
             if (new_socket < 0) continue;
 
+            // A stalled client must not hold up the other clients for long
+            struct timeval recvTimeout;
+            recvTimeout.tv_sec = 2;
+            recvTimeout.tv_usec = 0;
+            setsockopt(new_socket, SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, sizeof(recvTimeout));
+
             // Read the request to check headers
             char buffer[2048] = {0};
             ssize_t bytesRead = recv(new_socket, buffer, sizeof(buffer) - 1, 0);
             std::string request(buffer, bytesRead > 0 ? bytesRead : 0);
 
+            if (request.rfind("POST /config", 0) == 0) {
+                std::string response = handleConfig(new_socket, request);
+                send(new_socket, response.c_str(), response.length(), 0);
+                close(new_socket);
+                continue;
+            }
+
             // Get the configured API key
             const char* envKey = std::getenv("METRICS_API_KEY");
             std::string expectedKey = envKey ? envKey : "";
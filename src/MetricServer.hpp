@@ -6,10 +6,21 @@
 #include <thread>
 #include <atomic>
 #include <map>
+#include <functional>
+
+#include "Common.hpp"
 
 #include "HostMonitor.hpp" // New Include
 #include "IpmiController.hpp" // New Include
 #include "LlamaMonitor.hpp" // New Include
+#include "ActuationFilter.hpp"
+#include "ControlConfig.hpp"
+#include "CurveController.hpp"
+#include "PowerBudget.hpp"
+#include "ThermalModel.hpp"
+#include "ThrottleMeter.hpp"
+#include "TickScheduler.hpp"
+#include "RealtimeMode.hpp"
 
 namespace temper {
 
@@ -17,6 +28,55 @@ struct ProcessInfo {
     unsigned int pid;
     unsigned long long usedMemory;
     std::string name;
+    std::string cmdline;
+    unsigned int smUtil;
+    unsigned int memUtil;
+    unsigned int encUtil;
+    unsigned int decUtil;
+};
+
+struct MigComputeInstanceMetrics {
+    unsigned int id;
+    std::string uuid;
+    unsigned int sliceCount;
+    unsigned int multiprocessorCount;
+    std::vector<ProcessInfo> processes;
+};
+
+struct MigInstanceMetrics {
+    unsigned int id;
+    unsigned int sliceCount;
+    unsigned long long memTotal;
+    unsigned long long memUsed;
+    bool utilSupported;
+    double smUtil;
+    double memBwUtil;
+    std::vector<MigComputeInstanceMetrics> computeInstances;
+};
+
+struct NvLinkMetrics {
+    unsigned int link;
+    bool active;
+    unsigned int version;
+    std::string remoteBusId;
+    double txKBps;
+    double rxKBps;
+    unsigned long long crcFlitErrors;
+    unsigned long long crcDataErrors;
+    unsigned long long replayErrors;
+    unsigned long long recoveryErrors;
+    double errorsPerSec;
+};
+
+struct FanMetrics {
+    unsigned int index;
+    unsigned int speed;         // % reported
+    unsigned int target;        // % driver target
+    unsigned int commanded;     // % written by temper
+    unsigned int valid;         // GpuBackend::FAN_* bits read; the rest are emitted as null
+    unsigned int rpm;
+    bool manual;                // Fan control policy
+    bool stalled;
 };
 
 struct GpuMetrics {
@@ -27,14 +87,52 @@ struct GpuMetrics {
     unsigned int pState;
     std::string pStateDescription; 
 
-    unsigned int temp;
+    // Watchdog: while the device's driver calls are past their deadline the
+    // other fields hold its last good reading, staleSeconds old
+    bool responsive;
+    double staleSeconds;
+    unsigned long long hangEvents;
+
+    // Seconds since each telemetry group was collected (see TelemetryCollector); -1 = not yet
+    double samplesAgeSec = -1.0;
+    double linksAgeSec = -1.0;
+    double eccAgeSec = -1.0;
+    double processesAgeSec = -1.0;
+
+    unsigned int present;       // GpuBackend::CAP_* bits read this tick; absent values are emitted as null
+
+    unsigned int temp;          // Core
+    unsigned int memTemp;       // Memory junction / HBM, valid if memTempSupported
+    bool memTempSupported;
+    unsigned int controlTemp;   // Temperature fed to the curves this tick
+    std::string controlSensor;  // "core", "memory" or "forecast"
+    double curveTemp;           // controlTemp after TEMP_SMOOTHING_SEC, the actual curve input
     unsigned int fanSpeed;      
     unsigned int targetFan;     
+    std::vector<unsigned int> fanTargets; // Commanded per fan this tick (control side)
+    CurveController::PidStatus fanPid; // Closed-loop fan control state, if enabled
+    std::string fanCurveRule;   // GPU_FAN_CURVES selector that chose the curve, or "default"
+    std::vector<FanMetrics> fans;
     unsigned int powerUsage;    
     unsigned int powerLimit;    
     
     unsigned int utilGpu;       
     unsigned int utilMem;       
+
+    // Aggregates over the driver samples between two telemetry collections
+    unsigned int sampleCount;
+    double utilGpuAvg;
+    double utilGpuPeak;
+    double utilMemAvg;
+    double utilMemPeak;
+    double powerAvg;            // mW
+    double powerPeak;           // mW
+    double dutyCycle;           // % of samples with the GPU busy
+
+    double energyJoules;        // Monotonic, survives restarts
+    double energyAvgPowerW;     // From energy deltas over energyWindowSec
+    unsigned int energyWindowSec;
+    bool energyExact;           // false: integrated from power samples
     
     unsigned long long memTotal; 
     unsigned long long memUsed;  
@@ -48,11 +146,24 @@ struct GpuMetrics {
     unsigned int maxClockMemory;
     unsigned int maxClockSm;
     unsigned int maxClockVideo;
+    unsigned int lockedClockGraphics; // MHz, 0 when not locked by temper
+    unsigned int lockedClockMemory;
     
     unsigned int pcieTx; 
     unsigned int pcieRx; 
     unsigned int pcieGen;
     unsigned int pcieWidth;
+    unsigned int pcieMaxGen;
+    unsigned int pcieMaxWidth;
+    bool pcieReplaySupported;
+    unsigned int pcieReplayCounter;
+    double pcieReplaysPerSec;
+    bool pcieDegraded;          // Below max gen/width while under load
+    unsigned long long pcieDegradedEvents;
+
+    double nvlinkTxKBps;        // Sum over active links
+    double nvlinkRxKBps;
+    std::vector<NvLinkMetrics> nvlinks;
     
     unsigned long long eccVolatileSingle;
     unsigned long long eccVolatileDouble;
@@ -60,8 +171,21 @@ struct GpuMetrics {
     unsigned long long eccAggregateDouble;
 
     std::vector<ProcessInfo> processes;
+    std::vector<MigInstanceMetrics> migInstances;
     std::string throttleAlert;
     unsigned long long throttleReasonsBitmask;
+    ThrottleStats throttle;
+    ThermalPrediction thermal;
+
+    // Actuation (writes issued vs. suppressed as unchanged)
+    unsigned long long fanWrites;
+    unsigned long long fanWritesSuppressed;
+    unsigned long long powerWrites;
+    unsigned long long powerWritesSuppressed;
+    unsigned long long clockWrites;
+    unsigned long long clockWritesSuppressed;
+    unsigned long long actuationErrors;
+    SmoothingStats smoothing;
 };
 
 class MetricServer {
@@ -72,7 +196,12 @@ public:
     void start();
     void stop();
     // Updated Signature
-    void updateMetrics(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama);
+    void updateMetrics(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama, const PowerBudgetMetrics& budget, const ConfigStatus& config, const LoopStats& loop, const RealtimeStatus& realtime);
+
+    // Serves POST /config (requires CONFIG_API_KEY). Returns false with a message to reject the body.
+    // Setting a new handler (or nullptr) waits for a request in progress.
+    using ConfigHandler = std::function<bool(const std::string& body, std::string& message)>;
+    void setConfigHandler(ConfigHandler handler);
 
 private:
     void loop(); // Was serverLoop but cpp uses loop()
@@ -86,7 +215,12 @@ private:
     // Step 4306: MetricServer::loop() { ... select() ... }
     // It does not use handleClient or serverLoop names. it uses `loop`.
     
-    std::string buildJson(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama);
+    static std::string escapeJson(const std::string& s);
+    template <typename T>
+    static void writeOptional(std::ostream& oss, bool present, T value);
+    static void writeProcesses(std::ostream& oss, const std::vector<ProcessInfo>& processes);
+    std::string buildJson(const std::vector<GpuMetrics>& metrics, const HostMetrics& host, const IpmiMetrics& ipmi, const LlamaMetrics& llama, const PowerBudgetMetrics& budget, const ConfigStatus& config, const LoopStats& loop, const RealtimeStatus& realtime);
+    std::string handleConfig(int socket, const std::string& request);
 
     int m_port;
     std::atomic<bool> m_running;
@@ -94,6 +228,9 @@ private:
 
     std::string m_cachedJson;
     mutable std::mutex m_mutex;
+
+    ConfigHandler m_configHandler;
+    std::mutex m_configMutex; // Held while the handler runs
 };
 
 } // namespace temper
@@ -5,9 +5,12 @@ namespace temper {
 
 NVMLManager::NVMLManager() {
     checkResult(nvmlInit(), "Initialize NVML");
+    if (nvmlEventSetCreate(&migEvents_) != NVML_SUCCESS) migEvents_ = nullptr;
 }
 
 NVMLManager::~NVMLManager() {
+    for (auto& entry : migLayouts_) freeGpm(entry.second);
+    if (migEvents_) nvmlEventSetFree(migEvents_);
     nvmlShutdown();
 }
 
@@ -29,6 +32,70 @@ std::string NVMLManager::getUUID(nvmlDevice_t handle) const {
     return std::string(uuid);
 }
 
+unsigned int NVMLManager::probeCapabilities(nvmlDevice_t handle) const {
+    unsigned int caps = 0;
+    unsigned int value = 0;
+    unsigned long long value64 = 0;
+    nvmlUtilization_t util;
+    nvmlMemory_t mem;
+    if (nvmlDeviceGetTemperature(handle, NVML_TEMPERATURE_GPU, &value) == NVML_SUCCESS) caps |= CAP_TEMPERATURE;
+    if (nvmlDeviceGetPowerUsage(handle, &value) == NVML_SUCCESS) caps |= CAP_POWER_USAGE;
+    if (nvmlDeviceGetEnforcedPowerLimit(handle, &value) == NVML_SUCCESS) caps |= CAP_POWER_LIMIT;
+    if (nvmlDeviceGetUtilizationRates(handle, &util) == NVML_SUCCESS) caps |= CAP_UTILIZATION;
+    if (nvmlDeviceGetMemoryInfo(handle, &mem) == NVML_SUCCESS) caps |= CAP_MEMORY;
+    if (nvmlDeviceGetCurrentClocksThrottleReasons(handle, &value64) == NVML_SUCCESS) caps |= CAP_THROTTLE;
+    if (nvmlDeviceGetTotalEccErrors(handle, NVML_MEMORY_ERROR_TYPE_CORRECTED, NVML_VOLATILE_ECC, &value64) == NVML_SUCCESS) caps |= CAP_ECC;
+    nvmlFieldValue_t field = {};
+    field.fieldId = NVML_FI_DEV_MEMORY_TEMP;
+    if (nvmlDeviceGetFieldValues(handle, 1, &field) == NVML_SUCCESS && field.nvmlReturn == NVML_SUCCESS) caps |= CAP_MEMORY_TEMP;
+    return caps;
+}
+
+unsigned int NVMLManager::getCapabilities(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(capMutex_);
+    auto it = capabilities_.find(handle);
+    if (it == capabilities_.end()) it = capabilities_.emplace(handle, probeCapabilities(handle)).first;
+    return it->second;
+}
+
+void NVMLManager::dropCapability(nvmlDevice_t handle, unsigned int cap) const {
+    std::lock_guard<std::mutex> lock(capMutex_);
+    capabilities_[handle] &= ~cap;
+}
+
+NVMLManager::CoreReadings NVMLManager::readCore(nvmlDevice_t handle, unsigned int wanted) const {
+    unsigned int caps = getCapabilities(handle) & wanted;
+    CoreReadings r;
+    auto record = [&](unsigned int cap, nvmlReturn_t result) {
+        if (result == NVML_SUCCESS) r.valid |= cap;
+        else if (result == NVML_ERROR_NOT_SUPPORTED) dropCapability(handle, cap);
+    };
+
+    if (caps & CAP_TEMPERATURE) record(CAP_TEMPERATURE, nvmlDeviceGetTemperature(handle, NVML_TEMPERATURE_GPU, &r.temperature));
+    if (caps & CAP_POWER_USAGE) record(CAP_POWER_USAGE, nvmlDeviceGetPowerUsage(handle, &r.powerUsage));
+    if (caps & CAP_POWER_LIMIT) record(CAP_POWER_LIMIT, nvmlDeviceGetEnforcedPowerLimit(handle, &r.powerLimit));
+    if (caps & CAP_UTILIZATION) {
+        nvmlUtilization_t util;
+        nvmlReturn_t result = nvmlDeviceGetUtilizationRates(handle, &util);
+        if (result == NVML_SUCCESS) {
+            r.utilGpu = util.gpu;
+            r.utilMem = util.memory;
+        }
+        record(CAP_UTILIZATION, result);
+    }
+    if (caps & CAP_MEMORY) {
+        nvmlMemory_t mem;
+        nvmlReturn_t result = nvmlDeviceGetMemoryInfo(handle, &mem);
+        if (result == NVML_SUCCESS) {
+            r.memTotal = mem.total;
+            r.memUsed = mem.used;
+        }
+        record(CAP_MEMORY, result);
+    }
+    if (caps & CAP_THROTTLE) record(CAP_THROTTLE, nvmlDeviceGetCurrentClocksThrottleReasons(handle, &r.throttleReasons));
+    return r;
+}
+
 unsigned int NVMLManager::getTemperature(nvmlDevice_t handle) const {
     unsigned int temp = 0;
     checkResult(nvmlDeviceGetTemperature(handle, NVML_TEMPERATURE_GPU, &temp), "Get temperature");
@@ -42,12 +109,83 @@ unsigned int NVMLManager::getFanSpeed(nvmlDevice_t handle) const {
     return speed;
 }
 
+std::vector<NVMLManager::FanInfo> NVMLManager::getFans(nvmlDevice_t handle) const {
+    std::vector<FanInfo> fans(getNumFans(handle));
+    // Every field is tried on the first call; the ones a fan doesn't support are dropped
+    std::vector<unsigned int>& caps = deviceState(fanCapabilities_, fanCapMutex_, handle);
+    caps.resize(fans.size(), FAN_SPEED | FAN_TARGET | FAN_POLICY | FAN_RPM);
+    for (unsigned int i = 0; i < fans.size(); ++i) {
+        FanInfo& f = fans[i];
+        auto record = [&](unsigned int field, nvmlReturn_t result) {
+            if (result == NVML_SUCCESS) f.valid |= field;
+            else if (result == NVML_ERROR_NOT_SUPPORTED) caps[i] &= ~field;
+        };
+        if (caps[i] & FAN_SPEED) record(FAN_SPEED, nvmlDeviceGetFanSpeed_v2(handle, i, &f.speed));
+        if (caps[i] & FAN_TARGET) record(FAN_TARGET, nvmlDeviceGetTargetFanSpeed(handle, i, &f.target));
+        if (caps[i] & FAN_POLICY) {
+            nvmlFanControlPolicy_t policy = NVML_FAN_POLICY_TEMPERATURE_CONTINOUS_SW;
+            record(FAN_POLICY, nvmlDeviceGetFanControlPolicy_v2(handle, i, &policy));
+            f.policy = policy;
+        }
+
+        // The percentage is the intended speed; only the tachometer shows a blocked fan
+        if (caps[i] & FAN_RPM) {
+            nvmlFanSpeedInfo_t info;
+            info.version = nvmlFanSpeedInfo_v1;
+            info.fan = i;
+            info.speed = 0;
+            record(FAN_RPM, nvmlDeviceGetFanSpeedRPM(handle, &info));
+            f.rpm = info.speed;
+        }
+        if (!(f.valid & FAN_SPEED)) f.speed = 0;
+        if (!(f.valid & FAN_TARGET)) f.target = 0;
+        if (!(f.valid & FAN_RPM)) f.rpm = 0;
+    }
+    return fans;
+}
+
 unsigned int NVMLManager::getPowerUsage(nvmlDevice_t handle) const {
     unsigned int power = 0;
     checkResult(nvmlDeviceGetPowerUsage(handle, &power), "Get power usage");
     return power; // milliWatts
 }
 
+bool NVMLManager::getEnergyConsumption(nvmlDevice_t handle, unsigned long long& millijoules) const {
+    return nvmlDeviceGetTotalEnergyConsumption(handle, &millijoules) == NVML_SUCCESS; // Volta and newer
+}
+
+bool NVMLManager::getMemoryTemperature(nvmlDevice_t handle, unsigned int& celsius) const {
+    // Only exposed as a field value; typically HBM data-center parts
+    if (!(getCapabilities(handle) & CAP_MEMORY_TEMP)) return false;
+    nvmlFieldValue_t field = {};
+    field.fieldId = NVML_FI_DEV_MEMORY_TEMP;
+    nvmlReturn_t result = nvmlDeviceGetFieldValues(handle, 1, &field);
+    if (result == NVML_SUCCESS) result = field.nvmlReturn;
+    if (result == NVML_ERROR_NOT_SUPPORTED) dropCapability(handle, CAP_MEMORY_TEMP);
+    if (result != NVML_SUCCESS) return false;
+    celsius = field.value.uiVal;
+    return true;
+}
+
+bool NVMLManager::getSlowdownTemperature(nvmlDevice_t handle, unsigned int& celsius) const {
+    return nvmlDeviceGetTemperatureThreshold(handle, NVML_TEMPERATURE_THRESHOLD_SLOWDOWN, &celsius) == NVML_SUCCESS;
+}
+
+NVMLManager::ViolationTimes NVMLManager::getViolationTimes(nvmlDevice_t handle) const {
+    ViolationTimes v;
+    auto read = [&](nvmlPerfPolicyType_t policy, unsigned long long& ns) {
+        nvmlViolationTime_t t = {};
+        if (nvmlDeviceGetViolationStatus(handle, policy, &t) != NVML_SUCCESS) return;
+        ns = t.violationTime;
+        v.supported = true;
+    };
+    read(NVML_PERF_POLICY_POWER, v.powerNs);
+    read(NVML_PERF_POLICY_THERMAL, v.thermalNs);
+    read(NVML_PERF_POLICY_SYNC_BOOST, v.syncBoostNs);
+    read(NVML_PERF_POLICY_RELIABILITY, v.reliabilityNs);
+    return v;
+}
+
 unsigned int NVMLManager::getPowerLimit(nvmlDevice_t handle) const {
     unsigned int limit = 0;
     checkResult(nvmlDeviceGetEnforcedPowerLimit(handle, &limit), "Get power limit");
@@ -96,11 +234,22 @@ NVMLManager::PcieInfo NVMLManager::getPcieInfo(nvmlDevice_t handle) const {
     nvmlDeviceGetPcieThroughput(handle, NVML_PCIE_UTIL_RX_BYTES, &p.rxThroughput); // KB/s
     nvmlDeviceGetCurrPcieLinkGeneration(handle, &p.gen);
     nvmlDeviceGetCurrPcieLinkWidth(handle, &p.width);
+    p.replaySupported = nvmlDeviceGetPcieReplayCounter(handle, &p.replayCounter) == NVML_SUCCESS;
+
+    PcieLimits& limits = deviceState(pcieLimits_, pcieMutex_, handle);
+    if (!limits.probed) {
+        nvmlDeviceGetMaxPcieLinkGeneration(handle, &limits.maxGen);
+        nvmlDeviceGetMaxPcieLinkWidth(handle, &limits.maxWidth);
+        limits.probed = true;
+    }
+    p.maxGen = limits.maxGen;
+    p.maxWidth = limits.maxWidth;
     return p;
 }
 
 NVMLManager::EccCounts NVMLManager::getEccCounts(nvmlDevice_t handle) const {
     EccCounts e;
+    if (!(getCapabilities(handle) & CAP_ECC)) return e; // Consumer boards: don't query every tick
     // Volatile (since boot)
     nvmlDeviceGetTotalEccErrors(handle, NVML_MEMORY_ERROR_TYPE_CORRECTED, NVML_VOLATILE_ECC, &e.volatileSingle);
     nvmlDeviceGetTotalEccErrors(handle, NVML_MEMORY_ERROR_TYPE_UNCORRECTED, NVML_VOLATILE_ECC, &e.volatileDouble);
@@ -110,54 +259,84 @@ NVMLManager::EccCounts NVMLManager::getEccCounts(nvmlDevice_t handle) const {
     return e;
 }
 
-std::vector<NVMLManager::ProcessInfo> NVMLManager::getProcesses(nvmlDevice_t handle) const {
-    std::vector<ProcessInfo> processes;
+void NVMLManager::appendProcesses(nvmlDevice_t handle, bool graphics, std::vector<ProcessInfo>& out) const {
+    auto query = graphics ? nvmlDeviceGetGraphicsRunningProcesses : nvmlDeviceGetComputeRunningProcesses;
+
+    // First call to get count
     unsigned int infoCount = 0;
-    
-    // First call to get count - check for compute processes
-    nvmlReturn_t r = nvmlDeviceGetComputeRunningProcesses(handle, &infoCount, nullptr);
-    if (r == NVML_SUCCESS && infoCount > 0) {
-        std::vector<nvmlProcessInfo_t> infos(infoCount);
-        r = nvmlDeviceGetComputeRunningProcesses(handle, &infoCount, infos.data());
-        if (r == NVML_SUCCESS) {
-            for (unsigned int i = 0; i < infoCount; ++i) {
-                ProcessInfo p;
-                p.pid = infos[i].pid;
-                p.usedMemory = infos[i].usedGpuMemory;
-                
-                char name[256] = {0};
-                if (nvmlSystemGetProcessName(p.pid, name, 256) == NVML_SUCCESS) {
-                    p.name = std::string(name);
-                } else {
-                    p.name = "Unknown";
-                }
-                processes.push_back(p);
+    nvmlReturn_t r = query(handle, &infoCount, nullptr);
+    if (r != NVML_SUCCESS && r != NVML_ERROR_INSUFFICIENT_SIZE) return;
+    if (infoCount == 0) return;
+
+    std::vector<nvmlProcessInfo_t> infos(infoCount);
+    if (query(handle, &infoCount, infos.data()) != NVML_SUCCESS) return;
+
+    for (unsigned int i = 0; i < infoCount; ++i) {
+        ProcessInfo p;
+        p.pid = infos[i].pid;
+        p.usedMemory = infos[i].usedGpuMemory;
+        p.gpuInstanceId = infos[i].gpuInstanceId;
+        p.computeInstanceId = infos[i].computeInstanceId;
+
+        ProcessMeta meta;
+        if (!processCache_.lookup(p.pid, meta)) {
+            // Not visible in our /proc (no PID namespace sharing): ask the driver;
+            // a failed lookup is not cached, so it is retried next collection
+            char name[256] = {0};
+            if (nvmlSystemGetProcessName(p.pid, name, 256) == NVML_SUCCESS) {
+                meta.name = name;
+                processCache_.insert(p.pid, meta);
+            } else {
+                meta.name = "Unknown";
             }
         }
+        p.name = meta.name;
+        p.cmdline = meta.cmdline;
+        out.push_back(p);
     }
-    
-    // Also check for Graphics processes if separate
-    unsigned int gInfoCount = 0;
-    r = nvmlDeviceGetGraphicsRunningProcesses(handle, &gInfoCount, nullptr);
-    if (r == NVML_SUCCESS && gInfoCount > 0) {
-        std::vector<nvmlProcessInfo_t> gInfos(gInfoCount);
-        r = nvmlDeviceGetGraphicsRunningProcesses(handle, &gInfoCount, gInfos.data());
-        if (r == NVML_SUCCESS) {
-             for (unsigned int i = 0; i < gInfoCount; ++i) {
-                ProcessInfo p;
-                p.pid = gInfos[i].pid;
-                p.usedMemory = gInfos[i].usedGpuMemory;
-                 char name[256] = {0};
-                if (nvmlSystemGetProcessName(p.pid, name, 256) == NVML_SUCCESS) {
-                    p.name = std::string(name);
-                } else {
-                    p.name = "Unknown";
-                }
-                processes.push_back(p);
+}
+
+void NVMLManager::updateProcessUtilization(nvmlDevice_t handle, std::vector<ProcessInfo>& processes) const {
+    ProcessUtilState& state = deviceState(procUtil_, procUtilMutex_, handle);
+
+    // Only samples newer than lastSeen are returned, so each call drains just the new ones
+    unsigned int count = 0;
+    nvmlReturn_t r = nvmlDeviceGetProcessUtilization(handle, nullptr, &count, state.lastSeen);
+    if ((r == NVML_SUCCESS || r == NVML_ERROR_INSUFFICIENT_SIZE) && count > 0) {
+        std::vector<nvmlProcessUtilizationSample_t> samples(count);
+        if (nvmlDeviceGetProcessUtilization(handle, samples.data(), &count, state.lastSeen) == NVML_SUCCESS) {
+            std::unordered_map<unsigned int, unsigned long long> newest;
+            for (unsigned int i = 0; i < count; ++i) {
+                const auto& s = samples[i];
+                if (s.timeStamp > state.lastSeen) state.lastSeen = s.timeStamp;
+                auto it = newest.find(s.pid);
+                if (it != newest.end() && it->second > s.timeStamp) continue;
+                newest[s.pid] = s.timeStamp;
+                state.latest[s.pid] = {s.smUtil, s.memUtil, s.encUtil, s.decUtil};
             }
         }
     }
 
+    // Carry the last known sample between driver updates; forget exited processes
+    std::unordered_map<unsigned int, ProcessUtil> live;
+    for (auto& p : processes) {
+        auto it = state.latest.find(p.pid);
+        if (it == state.latest.end()) continue;
+        p.smUtil = it->second.sm;
+        p.memUtil = it->second.mem;
+        p.encUtil = it->second.enc;
+        p.decUtil = it->second.dec;
+        live.insert(*it);
+    }
+    state.latest.swap(live);
+}
+
+std::vector<NVMLManager::ProcessInfo> NVMLManager::getProcesses(nvmlDevice_t handle) const {
+    std::vector<ProcessInfo> processes;
+    appendProcesses(handle, false, processes);
+    // Also check for Graphics processes if separate
+    appendProcesses(handle, true, processes);
+    updateProcessUtilization(handle, processes);
     return processes;
 }
 
@@ -185,12 +364,261 @@ unsigned int NVMLManager::getPowerState(nvmlDevice_t handle) const {
     return 999;
 }
 
-void NVMLManager::setFanSpeed(nvmlDevice_t handle, unsigned int speedPercent) {
+unsigned int NVMLManager::getNumFans(nvmlDevice_t handle) const {
     unsigned int numFans = 0;
-    nvmlDeviceGetNumFans(handle, &numFans);
-    for (unsigned int i = 0; i < numFans; ++i) {
-        checkResult(nvmlDeviceSetFanSpeed_v2(handle, i, speedPercent), "Set fan speed");
+    if (nvmlDeviceGetNumFans(handle, &numFans) != NVML_SUCCESS) return 0; // Passively cooled
+    return numFans;
+}
+
+void NVMLManager::drainSampleBuffer(nvmlDevice_t handle, nvmlSamplingType_t type, unsigned long long& lastSeen, SampleWindow& window) const {
+    // First call to get count of samples newer than lastSeen
+    nvmlValueType_t valueType;
+    unsigned int count = 0;
+    if (nvmlDeviceGetSamples(handle, type, lastSeen, &valueType, &count, nullptr) != NVML_SUCCESS || count == 0) return;
+
+    std::vector<nvmlSample_t> raw(count);
+    if (nvmlDeviceGetSamples(handle, type, lastSeen, &valueType, &count, raw.data()) != NVML_SUCCESS) return;
+
+    double sum = 0.0;
+    unsigned long long newest = lastSeen;
+    for (unsigned int i = 0; i < count; ++i) {
+        if (raw[i].timeStamp <= lastSeen) continue;
+        const nvmlValue_t& v = raw[i].sampleValue;
+        double value = 0.0;
+        switch (valueType) {
+            case NVML_VALUE_TYPE_DOUBLE: value = v.dVal; break;
+            case NVML_VALUE_TYPE_UNSIGNED_INT: value = v.uiVal; break;
+            case NVML_VALUE_TYPE_UNSIGNED_LONG: value = v.ulVal; break;
+            case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: value = v.ullVal; break;
+            case NVML_VALUE_TYPE_SIGNED_LONG_LONG: value = v.sllVal; break;
+            default: value = v.uiVal; break;
+        }
+        window.count++;
+        if (value > 0) window.nonZero++;
+        sum += value;
+        if (value > window.peak) window.peak = value;
+        if (raw[i].timeStamp > newest) newest = raw[i].timeStamp;
     }
+    lastSeen = newest;
+    if (window.count > 0) window.average = sum / window.count;
+}
+
+NVMLManager::SampleWindows NVMLManager::drainSamples(nvmlDevice_t handle) const {
+    SampleCursor& cursor = deviceState(sampleCursors_, sampleMutex_, handle);
+    SampleWindows w;
+    drainSampleBuffer(handle, NVML_GPU_UTILIZATION_SAMPLES, cursor.gpuUtil, w.gpuUtil);
+    drainSampleBuffer(handle, NVML_MEMORY_UTILIZATION_SAMPLES, cursor.memUtil, w.memUtil);
+    drainSampleBuffer(handle, NVML_TOTAL_POWER_SAMPLES, cursor.power, w.power);
+    return w;
+}
+
+void NVMLManager::pollMigEvents() const {
+    if (!migEvents_) return;
+    nvmlEventData_t data;
+    // Non-blocking: drain whatever reconfiguration events are pending
+    while (nvmlEventSetWait_v2(migEvents_, &data, 0) == NVML_SUCCESS) {
+        if (data.eventType & nvmlEventMigConfigChange) {
+            migLayouts_[data.device].probed = false;
+        }
+    }
+}
+
+void NVMLManager::freeGpm(MigLayout& layout) {
+    for (auto& entry : layout.gpm) {
+        if (entry.second.prev) nvmlGpmSampleFree(entry.second.prev);
+        if (entry.second.cur) nvmlGpmSampleFree(entry.second.cur);
+    }
+    layout.gpm.clear();
+}
+
+void NVMLManager::probeMigLayout(nvmlDevice_t handle, MigLayout& layout) const {
+    freeGpm(layout);
+    layout.handles.clear();
+    layout.probed = true;
+    layout.probedAt = std::chrono::steady_clock::now();
+
+    unsigned int currentMode = 0, pendingMode = 0;
+    if (nvmlDeviceGetMigMode(handle, &currentMode, &pendingMode) != NVML_SUCCESS) {
+        layout.capable = false;
+        return;
+    }
+    if (!layout.eventsRegistered && migEvents_) {
+        layout.eventsRegistered = nvmlDeviceRegisterEvents(handle, nvmlEventMigConfigChange, migEvents_) == NVML_SUCCESS;
+    }
+    if (currentMode != NVML_DEVICE_MIG_ENABLE) return;
+
+    nvmlGpmSupport_t gpmSupport;
+    gpmSupport.version = NVML_GPM_SUPPORT_VERSION;
+    layout.gpmSupported = nvmlGpmQueryDeviceSupport(handle, &gpmSupport) == NVML_SUCCESS && gpmSupport.isSupportedDevice;
+
+    unsigned int maxCount = 0;
+    if (nvmlDeviceGetMaxMigDeviceCount(handle, &maxCount) != NVML_SUCCESS) return;
+    for (unsigned int i = 0; i < maxCount; ++i) {
+        MigHandle mig;
+        // Indices are sparse: unused slots report NOT_FOUND
+        if (nvmlDeviceGetMigDeviceHandleByIndex(handle, i, &mig.handle) != NVML_SUCCESS) continue;
+        if (nvmlDeviceGetGpuInstanceId(mig.handle, &mig.gpuInstanceId) != NVML_SUCCESS) continue;
+        if (nvmlDeviceGetComputeInstanceId(mig.handle, &mig.computeInstanceId) != NVML_SUCCESS) continue;
+        char uuid[80] = {0};
+        if (nvmlDeviceGetUUID(mig.handle, uuid, 80) == NVML_SUCCESS) mig.uuid = uuid;
+        if (nvmlDeviceGetAttributes(mig.handle, &mig.attributes) != NVML_SUCCESS) mig.attributes = {};
+        layout.handles.push_back(mig);
+    }
+}
+
+void NVMLManager::sampleGpm(nvmlDevice_t handle, MigLayout& layout, MigGpuInstance& instance) const {
+    GpmState& g = layout.gpm[instance.id];
+    if (!g.cur && nvmlGpmSampleAlloc(&g.cur) != NVML_SUCCESS) return;
+    if (!g.prev && nvmlGpmSampleAlloc(&g.prev) != NVML_SUCCESS) return;
+    if (nvmlGpmMigSampleGet(handle, instance.id, g.cur) != NVML_SUCCESS) return;
+
+    // GPM metrics are rates between two samples, so the first tick only primes
+    if (g.hasPrev) {
+        nvmlGpmMetricsGet_t mg = {};
+        mg.version = NVML_GPM_METRICS_GET_VERSION;
+        mg.numMetrics = 2;
+        mg.sample1 = g.prev;
+        mg.sample2 = g.cur;
+        mg.metrics[0].metricId = NVML_GPM_METRIC_SM_UTIL;
+        mg.metrics[1].metricId = NVML_GPM_METRIC_DRAM_BW_UTIL;
+        if (nvmlGpmMetricsGet(&mg) == NVML_SUCCESS && mg.metrics[0].nvmlReturn == NVML_SUCCESS) {
+            instance.utilSupported = true;
+            instance.smUtil = mg.metrics[0].value;
+            if (mg.metrics[1].nvmlReturn == NVML_SUCCESS) instance.memBwUtil = mg.metrics[1].value;
+        }
+    }
+    std::swap(g.prev, g.cur);
+    g.hasPrev = true;
+}
+
+std::vector<NVMLManager::MigGpuInstance> NVMLManager::getMigInstances(nvmlDevice_t handle) const {
+    MigLayout* entry;
+    {
+        std::lock_guard<std::mutex> lock(migMutex_);
+        pollMigEvents();
+        entry = &migLayouts_[handle];
+    }
+    MigLayout& layout = *entry;
+    if (!layout.capable) return {};
+    auto now = std::chrono::steady_clock::now();
+    if (!layout.probed || (!layout.eventsRegistered && now - layout.probedAt >= MIG_REPROBE_INTERVAL)) {
+        probeMigLayout(handle, layout);
+    }
+
+    std::map<unsigned int, MigGpuInstance> byId;
+    for (const auto& mig : layout.handles) {
+        auto inserted = byId.emplace(mig.gpuInstanceId, MigGpuInstance());
+        MigGpuInstance& gi = inserted.first->second;
+        if (inserted.second) {
+            // Memory belongs to the GPU instance and is shared by its compute instances
+            gi.id = mig.gpuInstanceId;
+            gi.sliceCount = mig.attributes.gpuInstanceSliceCount;
+            nvmlMemory_t mem;
+            if (nvmlDeviceGetMemoryInfo(mig.handle, &mem) == NVML_SUCCESS) {
+                gi.memTotal = mem.total;
+                gi.memUsed = mem.used;
+            }
+        }
+        MigComputeInstance ci;
+        ci.id = mig.computeInstanceId;
+        ci.uuid = mig.uuid;
+        ci.sliceCount = mig.attributes.computeInstanceSliceCount;
+        ci.multiprocessorCount = mig.attributes.multiprocessorCount;
+        gi.computeInstances.push_back(ci);
+    }
+
+    std::vector<MigGpuInstance> instances;
+    for (auto& entry : byId) {
+        if (layout.gpmSupported) sampleGpm(handle, layout, entry.second);
+        instances.push_back(std::move(entry.second));
+    }
+    return instances;
+}
+
+void NVMLManager::discoverNvLinks(nvmlDevice_t handle, NvLinkState& state) const {
+    state.discovered = true;
+    for (unsigned int link = 0; link < NVML_NVLINK_MAX_LINKS; ++link) {
+        nvmlEnableState_t isActive = NVML_FEATURE_DISABLED;
+        nvmlReturn_t r = nvmlDeviceGetNvLinkState(handle, link, &isActive);
+        if (r == NVML_ERROR_NOT_SUPPORTED && link == 0) return; // No NVLink on this GPU
+        if (r != NVML_SUCCESS) continue;
+
+        NvLinkInfo info;
+        info.link = link;
+        state.links.push_back(info);
+    }
+}
+
+// Version and peer are only reported while the link is up; filled in the first time it is
+void NVMLManager::readNvLinkPeer(nvmlDevice_t handle, NvLinkInfo& l) const {
+    nvmlDeviceGetNvLinkVersion(handle, l.link, &l.version);
+    nvmlPciInfo_t pci;
+    if (nvmlDeviceGetNvLinkRemotePciInfo(handle, l.link, &pci) == NVML_SUCCESS) {
+        l.remoteBusId = pci.busId;
+    }
+}
+
+static unsigned long long counterDelta(unsigned long long now, unsigned long long prev) {
+    return now >= prev ? now - prev : 0; // Counter reset (e.g. driver reload)
+}
+
+std::vector<NVMLManager::NvLinkInfo> NVMLManager::getNvLinks(nvmlDevice_t handle) const {
+    NvLinkState& state = deviceState(nvLinks_, nvLinkMutex_, handle);
+    if (!state.discovered) discoverNvLinks(handle, state);
+    if (state.links.empty()) return {};
+
+    // Throughput for all links in one call; scopeId selects the link
+    std::vector<nvmlFieldValue_t> fields(state.links.size() * 2);
+    for (size_t i = 0; i < state.links.size(); ++i) {
+        fields[i * 2] = {};
+        fields[i * 2].fieldId = NVML_FI_DEV_NVLINK_THROUGHPUT_DATA_TX;
+        fields[i * 2].scopeId = state.links[i].link;
+        fields[i * 2 + 1] = {};
+        fields[i * 2 + 1].fieldId = NVML_FI_DEV_NVLINK_THROUGHPUT_DATA_RX;
+        fields[i * 2 + 1].scopeId = state.links[i].link;
+    }
+    bool haveThroughput = nvmlDeviceGetFieldValues(handle, fields.size(), fields.data()) == NVML_SUCCESS;
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - state.lastRead).count();
+    bool haveRates = state.lastRead.time_since_epoch().count() != 0 && elapsed > 0.0;
+    state.lastRead = now;
+
+    for (size_t i = 0; i < state.links.size(); ++i) {
+        NvLinkInfo& l = state.links[i];
+        NvLinkInfo prev = l;
+
+        nvmlEnableState_t isActive = NVML_FEATURE_DISABLED;
+        l.active = nvmlDeviceGetNvLinkState(handle, l.link, &isActive) == NVML_SUCCESS && isActive == NVML_FEATURE_ENABLED;
+        if (l.active && l.remoteBusId.empty()) readNvLinkPeer(handle, l);
+        if (!l.active) {
+            l.txKBps = l.rxKBps = l.errorsPerSec = 0.0;
+            continue;
+        }
+
+        if (haveThroughput && fields[i * 2].nvmlReturn == NVML_SUCCESS) l.txKiB = fields[i * 2].value.ullVal;
+        if (haveThroughput && fields[i * 2 + 1].nvmlReturn == NVML_SUCCESS) l.rxKiB = fields[i * 2 + 1].value.ullVal;
+        nvmlDeviceGetNvLinkErrorCounter(handle, l.link, NVML_NVLINK_ERROR_DL_CRC_FLIT, &l.crcFlitErrors);
+        nvmlDeviceGetNvLinkErrorCounter(handle, l.link, NVML_NVLINK_ERROR_DL_CRC_DATA, &l.crcDataErrors);
+        nvmlDeviceGetNvLinkErrorCounter(handle, l.link, NVML_NVLINK_ERROR_DL_REPLAY, &l.replayErrors);
+        nvmlDeviceGetNvLinkErrorCounter(handle, l.link, NVML_NVLINK_ERROR_DL_RECOVERY, &l.recoveryErrors);
+
+        // Counters from before a link went down would turn into a burst on the first reading back up
+        if (haveRates && prev.active) {
+            l.txKBps = counterDelta(l.txKiB, prev.txKiB) / elapsed;
+            l.rxKBps = counterDelta(l.rxKiB, prev.rxKiB) / elapsed;
+            unsigned long long errors = counterDelta(l.crcFlitErrors, prev.crcFlitErrors)
+                                      + counterDelta(l.crcDataErrors, prev.crcDataErrors)
+                                      + counterDelta(l.replayErrors, prev.replayErrors)
+                                      + counterDelta(l.recoveryErrors, prev.recoveryErrors);
+            l.errorsPerSec = errors / elapsed;
+        }
+    }
+    return state.links;
+}
+
+void NVMLManager::setFanSpeed(nvmlDevice_t handle, unsigned int fan, unsigned int speedPercent) {
+    checkResult(nvmlDeviceSetFanSpeed_v2(handle, fan, speedPercent), "Set fan speed");
 }
 
 void NVMLManager::setPowerLimit(nvmlDevice_t handle, unsigned int watts) {
@@ -214,6 +642,20 @@ void NVMLManager::restoreAutoFans(nvmlDevice_t handle) {
     }
 }
 
+void NVMLManager::setGpuLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) {
+    checkResult(nvmlDeviceSetGpuLockedClocks(handle, minMHz, maxMHz), "Set GPU locked clocks");
+}
+
+void NVMLManager::setMemoryLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) {
+    checkResult(nvmlDeviceSetMemoryLockedClocks(handle, minMHz, maxMHz), "Set memory locked clocks");
+}
+
+void NVMLManager::resetLockedClocks(nvmlDevice_t handle) {
+    // Best effort: called on shutdown and when a lock is rejected
+    nvmlDeviceResetGpuLockedClocks(handle);
+    nvmlDeviceResetMemoryLockedClocks(handle);
+}
+
 unsigned long long NVMLManager::getThrottleReasons(nvmlDevice_t handle) const {
     unsigned long long reasons = 0;
     checkResult(nvmlDeviceGetCurrentClocksThrottleReasons(handle, &reasons), "Get throttle reasons");
@@ -222,7 +664,7 @@ unsigned long long NVMLManager::getThrottleReasons(nvmlDevice_t handle) const {
 
 void NVMLManager::checkResult(nvmlReturn_t result, const std::string& action) const {
     if (result != NVML_SUCCESS) {
-        throw std::runtime_error(action + " failed: " + nvmlErrorString(result));
+        throw BackendError(action + " failed: " + nvmlErrorString(result), result);
     }
 }
 
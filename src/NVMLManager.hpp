@@ -1,14 +1,21 @@
 #pragma once
 
 #include "Common.hpp"
+#include "GpuBackend.hpp"
+#include "ProcessCache.hpp"
 #include <nvml.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <stdexcept>
 
 namespace temper {
 
-class NVMLManager {
+class NVMLManager : public GpuBackend {
 public:
     NVMLManager();
     ~NVMLManager();
@@ -17,66 +24,146 @@ public:
     NVMLManager(const NVMLManager&) = delete;
     NVMLManager& operator=(const NVMLManager&) = delete;
 
-    unsigned int getDeviceCount() const;
-    nvmlDevice_t getHandle(unsigned int index) const;
-    std::string getUUID(nvmlDevice_t handle) const;
+    unsigned int getDeviceCount() const override;
+    nvmlDevice_t getHandle(unsigned int index) const override;
+    std::string getUUID(nvmlDevice_t handle) const override;
+    unsigned int getCapabilities(nvmlDevice_t handle) const override;
+    CoreReadings readCore(nvmlDevice_t handle, unsigned int wanted) const override;
+
+    unsigned int getTemperature(nvmlDevice_t handle) const override;
+    unsigned int getFanSpeed(nvmlDevice_t handle) const override;
+    std::vector<FanInfo> getFans(nvmlDevice_t handle) const override;
+    unsigned int getPowerUsage(nvmlDevice_t handle) const override;
+    unsigned int getPowerLimit(nvmlDevice_t handle) const override;
+    void getUtilization(nvmlDevice_t handle, unsigned int& gpu, unsigned int& memory) const override;
+    void getMemoryInfo(nvmlDevice_t handle, unsigned long long& total, unsigned long long& used) const override;
+    std::string getName(nvmlDevice_t handle) const override;
     
-    struct Clocks {
-        unsigned int graphics = 0;
-        unsigned int memory = 0;
+    // Advanced Metrics
+    Clocks getClocks(nvmlDevice_t handle) const override;
+    PcieInfo getPcieInfo(nvmlDevice_t handle) const override;
+    EccCounts getEccCounts(nvmlDevice_t handle) const override;
+    std::vector<ProcessInfo> getProcesses(nvmlDevice_t handle) const override;
+    std::string getVbiosVersion(nvmlDevice_t handle) const override;
+    std::string getSerial(nvmlDevice_t handle) const override;
+    unsigned int getPowerState(nvmlDevice_t handle) const override; // P-State
+    SampleWindows drainSamples(nvmlDevice_t handle) const override;
+    std::vector<MigGpuInstance> getMigInstances(nvmlDevice_t handle) const override;
+    std::vector<NvLinkInfo> getNvLinks(nvmlDevice_t handle) const override;
+    bool getEnergyConsumption(nvmlDevice_t handle, unsigned long long& millijoules) const override;
+    bool getMemoryTemperature(nvmlDevice_t handle, unsigned int& celsius) const override;
+    bool getSlowdownTemperature(nvmlDevice_t handle, unsigned int& celsius) const override;
+    ViolationTimes getViolationTimes(nvmlDevice_t handle) const override;
+
+    unsigned int getNumFans(nvmlDevice_t handle) const override;
+    void setFanSpeed(nvmlDevice_t handle, unsigned int fan, unsigned int speedPercent) override;
+    void setPowerLimit(nvmlDevice_t handle, unsigned int watts) override;
+    void getPowerConstraints(nvmlDevice_t handle, unsigned int& minW, unsigned int& maxW) const override;
+    void restoreAutoFans(nvmlDevice_t handle) override;
+    void setGpuLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) override;
+    void setMemoryLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) override;
+    void resetLockedClocks(nvmlDevice_t handle) override;
+    unsigned long long getThrottleReasons(nvmlDevice_t handle) const override;
+
+private:
+    struct ProcessUtil {
         unsigned int sm = 0;
-        unsigned int video = 0;
-        unsigned int maxGraphics = 0;
-        unsigned int maxMemory = 0;
-        unsigned int maxSm = 0;
-        unsigned int maxVideo = 0;
+        unsigned int mem = 0;
+        unsigned int enc = 0;
+        unsigned int dec = 0;
     };
-    
-    struct PcieInfo {
-        unsigned int txThroughput = 0; // KB/s
-        unsigned int rxThroughput = 0; // KB/s
-        unsigned int gen = 0;
-        unsigned int width = 0;
+
+    struct ProcessUtilState {
+        unsigned long long lastSeen = 0; // Newest sample timestamp consumed (us)
+        std::unordered_map<unsigned int, ProcessUtil> latest;
     };
 
-    struct EccCounts {
-        unsigned long long volatileSingle = 0;
-        unsigned long long volatileDouble = 0;
-        unsigned long long aggregateSingle = 0;
-        unsigned long long aggregateDouble = 0;
+    struct SampleCursor {
+        unsigned long long gpuUtil = 0; // Newest sample timestamp consumed per buffer (us)
+        unsigned long long memUtil = 0;
+        unsigned long long power = 0;
     };
 
-    struct ProcessInfo {
-        unsigned int pid = 0;
-        unsigned long long usedMemory = 0; // Bytes
-        std::string name = "";
+    struct MigHandle {
+        nvmlDevice_t handle;
+        unsigned int gpuInstanceId;
+        unsigned int computeInstanceId;
+        std::string uuid;
+        nvmlDeviceAttributes_t attributes;
     };
 
-    unsigned int getTemperature(nvmlDevice_t handle) const;
-    unsigned int getFanSpeed(nvmlDevice_t handle) const;
-    unsigned int getPowerUsage(nvmlDevice_t handle) const;
-    unsigned int getPowerLimit(nvmlDevice_t handle) const;
-    void getUtilization(nvmlDevice_t handle, unsigned int& gpu, unsigned int& memory) const;
-    void getMemoryInfo(nvmlDevice_t handle, unsigned long long& total, unsigned long long& used) const;
-    std::string getName(nvmlDevice_t handle) const;
-    
-    // Advanced Metrics
-    Clocks getClocks(nvmlDevice_t handle) const;
-    PcieInfo getPcieInfo(nvmlDevice_t handle) const;
-    EccCounts getEccCounts(nvmlDevice_t handle) const;
-    std::vector<ProcessInfo> getProcesses(nvmlDevice_t handle) const;
-    std::string getVbiosVersion(nvmlDevice_t handle) const;
-    std::string getSerial(nvmlDevice_t handle) const;
-    unsigned int getPowerState(nvmlDevice_t handle) const; // P-State
-
-    void setFanSpeed(nvmlDevice_t handle, unsigned int speedPercent);
-    void setPowerLimit(nvmlDevice_t handle, unsigned int watts);
-    void getPowerConstraints(nvmlDevice_t handle, unsigned int& minW, unsigned int& maxW) const;
-    void restoreAutoFans(nvmlDevice_t handle);
-    unsigned long long getThrottleReasons(nvmlDevice_t handle) const;
+    struct GpmState {
+        nvmlGpmSample_t prev = nullptr;
+        nvmlGpmSample_t cur = nullptr;
+        bool hasPrev = false;
+    };
+
+    // Partition layout is cached and only re-probed on MIG reconfiguration events
+    struct MigLayout {
+        std::atomic<bool> probed{false}; // Cleared by reconfiguration events from any thread
+        bool capable = true;          // false: MIG unsupported, never probe again
+        bool eventsRegistered = false;
+        bool gpmSupported = false;
+        std::chrono::steady_clock::time_point probedAt;
+        std::vector<MigHandle> handles;
+        std::map<unsigned int, GpmState> gpm; // Per GPU instance
+    };
+
+    // Links present on the board are discovered once; their state is re-read on every
+    // call, and the previous reading is kept for rate computation
+    struct NvLinkState {
+        bool discovered = false;
+        std::vector<NvLinkInfo> links; // Every link the driver reports a state for
+        std::chrono::steady_clock::time_point lastRead;
+    };
+
+    struct PcieLimits {
+        bool probed = false;
+        unsigned int maxGen = 0;
+        unsigned int maxWidth = 0;
+    };
+
+    static constexpr std::chrono::seconds MIG_REPROBE_INTERVAL{60}; // Only without event support
 
-private:
     void checkResult(nvmlReturn_t result, const std::string& action) const;
+
+    // Per-device state is only touched by the thread polling that device, so the
+    // shared maps are locked just for the lookup, never across driver calls (a
+    // hung GPU must not block the others). Node-based maps keep the reference valid.
+    template <typename State>
+    static State& deviceState(std::unordered_map<nvmlDevice_t, State>& map, std::mutex& mutex, nvmlDevice_t handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map[handle];
+    }
+
+    unsigned int probeCapabilities(nvmlDevice_t handle) const;
+    void dropCapability(nvmlDevice_t handle, unsigned int cap) const;
+    void pollMigEvents() const;
+    void probeMigLayout(nvmlDevice_t handle, MigLayout& layout) const;
+    void sampleGpm(nvmlDevice_t handle, MigLayout& layout, MigGpuInstance& instance) const;
+    static void freeGpm(MigLayout& layout);
+    void discoverNvLinks(nvmlDevice_t handle, NvLinkState& state) const;
+    void readNvLinkPeer(nvmlDevice_t handle, NvLinkInfo& l) const;
+    void drainSampleBuffer(nvmlDevice_t handle, nvmlSamplingType_t type, unsigned long long& lastSeen, SampleWindow& window) const;
+    void appendProcesses(nvmlDevice_t handle, bool graphics, std::vector<ProcessInfo>& out) const;
+    void updateProcessUtilization(nvmlDevice_t handle, std::vector<ProcessInfo>& processes) const;
+
+    mutable ProcessCache processCache_;
+    mutable std::unordered_map<nvmlDevice_t, ProcessUtilState> procUtil_;
+    mutable std::mutex procUtilMutex_;
+    mutable std::unordered_map<nvmlDevice_t, SampleCursor> sampleCursors_;
+    mutable std::mutex sampleMutex_;
+    mutable std::unordered_map<nvmlDevice_t, MigLayout> migLayouts_;
+    mutable std::mutex migMutex_;
+    nvmlEventSet_t migEvents_ = nullptr;
+    mutable std::unordered_map<nvmlDevice_t, NvLinkState> nvLinks_;
+    mutable std::mutex nvLinkMutex_;
+    mutable std::unordered_map<nvmlDevice_t, unsigned int> capabilities_;
+    mutable std::mutex capMutex_;
+    mutable std::unordered_map<nvmlDevice_t, std::vector<unsigned int>> fanCapabilities_; // FAN_* bits per fan
+    mutable std::mutex fanCapMutex_;
+    mutable std::unordered_map<nvmlDevice_t, PcieLimits> pcieLimits_; // Fixed for the life of the link
+    mutable std::mutex pcieMutex_;
 };
 
 } // namespace temper
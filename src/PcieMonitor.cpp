@@ -0,0 +1,58 @@
+#include "PcieMonitor.hpp"
+#include <cstdlib>
+#include <iostream>
+
+namespace temper {
+
+PcieMonitor::PcieMonitor() {
+    const char* dEnv = std::getenv("PCIE_DEGRADED_SEC");
+    if (dEnv) degradedAfter_ = std::chrono::seconds(std::strtoul(dEnv, nullptr, 10));
+}
+
+PcieStatus PcieMonitor::update(unsigned int device, const GpuBackend::PcieInfo& info, bool busy) {
+    State* entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry = &states_[device];
+    }
+    State& s = *entry;
+    auto now = Clock::now();
+
+    // Rate over >= 1s intervals; per-tick deltas of a slow counter are mostly 0
+    double dt = std::chrono::duration<double>(now - s.lastReplayRead).count();
+    if (info.replaySupported && (!s.haveReplay || dt >= 1.0)) {
+        if (s.haveReplay && info.replayCounter >= s.lastReplay) {
+            s.status.replaysPerSec = (info.replayCounter - s.lastReplay) / dt;
+        }
+        s.haveReplay = true;
+        s.lastReplay = info.replayCounter;
+        s.lastReplayRead = now;
+    }
+
+    // Max values of 0 mean the driver didn't report them; nothing to compare against
+    if (!busy || info.maxGen == 0 || info.maxWidth == 0) return s.status;
+
+    bool below = info.gen < info.maxGen || info.width < info.maxWidth;
+    if (!below) {
+        if (s.status.degraded) {
+            std::cout << "[PCIe] GPU " << device << " link back at Gen" << info.gen << " x" << info.width << std::endl;
+        }
+        s.status.degraded = false;
+        s.below = false;
+        return s.status;
+    }
+
+    if (!s.below) {
+        s.below = true;
+        s.belowSince = now;
+    }
+    if (!s.status.degraded && now - s.belowSince >= degradedAfter_) {
+        s.status.degraded = true;
+        s.status.degradedEvents++;
+        std::cerr << "[PCIe] GPU " << device << " link degraded under load: Gen" << info.gen << " x" << info.width
+                  << " (max Gen" << info.maxGen << " x" << info.maxWidth << ")" << std::endl;
+    }
+    return s.status;
+}
+
+} // namespace temper
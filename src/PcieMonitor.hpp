@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GpuBackend.hpp"
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace temper {
+
+struct PcieStatus {
+    bool degraded = false;
+    double replaysPerSec = 0.0;
+    unsigned long long degradedEvents = 0;
+};
+
+// Detects PCIe links running below their negotiated maximum.
+//
+// Idle GPUs legitimately drop to Gen1 to save power, so the link is only
+// judged while the GPU is busy, and must stay below max gen or width for
+// PCIE_DEGRADED_SEC seconds (default 5) before it is flagged. A degraded
+// link stays flagged until it is seen at full speed under load again.
+// Transitions are logged.
+class PcieMonitor {
+public:
+    PcieMonitor();
+
+    PcieStatus update(unsigned int device, const GpuBackend::PcieInfo& info, bool busy);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct State {
+        PcieStatus status;
+        bool below = false;
+        Clock::time_point belowSince;
+        bool haveReplay = false;
+        unsigned int lastReplay = 0;
+        Clock::time_point lastReplayRead;
+    };
+
+    std::mutex mutex_; // Guards the map only; each entry belongs to one device's poller
+    std::map<unsigned int, State> states_;
+    Clock::duration degradedAfter_ = std::chrono::seconds(5);
+};
+
+} // namespace temper
@@ -0,0 +1,122 @@
+#include "PowerBudget.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace temper {
+
+PowerBudget::PowerBudget() {
+    const char* bEnv = std::getenv("NODE_POWER_BUDGET_W");
+    if (bEnv) budgetW_ = std::strtoul(bEnv, nullptr, 10);
+
+    const char* sEnv = std::getenv("POWER_BUDGET_STEP_W");
+    if (sEnv) stepW_ = std::max(1ul, std::strtoul(sEnv, nullptr, 10));
+
+    const char* mEnv = std::getenv("POWER_BUDGET_MARGIN_W");
+    if (mEnv) marginW_ = std::strtoul(mEnv, nullptr, 10);
+
+    metrics_.enabled = budgetW_ > 0;
+    metrics_.budgetW = budgetW_;
+    lastTick_ = Clock::now();
+}
+
+// Hands out `remaining` in proportion to weight, never beyond cap, redistributing
+// whatever a capped device could not take
+void PowerBudget::waterFill(std::vector<double>& alloc, const std::vector<double>& cap,
+                            const std::vector<double>& weight, double& remaining) {
+    for (size_t pass = 0; pass < alloc.size() && remaining > 0.01; ++pass) {
+        double totalWeight = 0.0;
+        for (size_t i = 0; i < alloc.size(); ++i) {
+            if (alloc[i] < cap[i]) totalWeight += weight[i];
+        }
+        if (totalWeight <= 0.0) break;
+
+        double given = 0.0;
+        for (size_t i = 0; i < alloc.size(); ++i) {
+            if (alloc[i] >= cap[i]) continue;
+            double share = std::min(remaining * weight[i] / totalWeight, cap[i] - alloc[i]);
+            alloc[i] += share;
+            given += share;
+        }
+        remaining -= given;
+    }
+}
+
+std::vector<unsigned int> PowerBudget::allocate(const std::vector<Demand>& gpus, const IpmiMetrics& ipmi) {
+    auto now = Clock::now();
+    size_t n = gpus.size();
+
+    double gpuDraw = 0.0;
+    for (const auto& g : gpus) gpuDraw += g.drawW;
+
+    // IPMI lags by seconds: smooth the non-GPU share rather than chase each reading
+    metrics_.chassisMeasured = ipmi.available && ipmi.powerConsumption > 0;
+    if (metrics_.chassisMeasured) {
+        double sample = std::max(0.0, (double)ipmi.powerConsumption - gpuDraw);
+        nonGpuW_ = haveNonGpu_ ? nonGpuW_ + 0.05 * (sample - nonGpuW_) : sample;
+        haveNonGpu_ = true;
+    }
+    double nonGpu = metrics_.chassisMeasured ? nonGpuW_ : 0.0;
+    metrics_.nodePowerW = nonGpu + gpuDraw;
+    metrics_.gpuBudgetW = std::max(0.0, (double)budgetW_ - marginW_ - nonGpu);
+
+    std::vector<double> alloc(n), want(n), cap(n), weight(n);
+    double remaining = metrics_.gpuBudgetW;
+    for (size_t i = 0; i < n; ++i) {
+        const Demand& g = gpus[i];
+        alloc[i] = g.minW;
+        remaining -= g.minW;
+
+        if (g.forceMin) {
+            want[i] = cap[i] = g.minW;
+        } else {
+            // Capped GPUs borrow a step at a time; the rest release what they don't draw
+            want[i] = g.capped ? g.limitW + stepW_ : g.drawW * 1.1 + stepW_;
+            want[i] = std::clamp(want[i], (double)g.minW, (double)g.maxW);
+            cap[i] = g.maxW;
+        }
+        weight[i] = g.util + 1.0; // Idle GPUs still get a share of true surplus
+    }
+
+    metrics_.feasible = remaining >= 0.0;
+    if (metrics_.feasible) {
+        waterFill(alloc, want, weight, remaining);
+        waterFill(alloc, cap, weight, remaining);
+    }
+
+    std::vector<unsigned int> limits(n);
+    metrics_.allocatedW = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        limits[i] = (unsigned int)std::floor(alloc[i]);
+        metrics_.allocatedW += limits[i];
+    }
+
+    trackOvershoot(now);
+    return limits;
+}
+
+// Overshoot beyond 1% of the budget opens an episode; its length is the settle time
+void PowerBudget::trackOvershoot(Clock::time_point now) {
+    double dt = std::chrono::duration<double>(now - lastTick_).count();
+    lastTick_ = now;
+
+    metrics_.overshootW = std::max(0.0, metrics_.nodePowerW - budgetW_);
+    bool over = metrics_.overshootW > budgetW_ * 0.01;
+    if (over) {
+        metrics_.peakOvershootW = std::max(metrics_.peakOvershootW, metrics_.overshootW);
+        metrics_.overshootSeconds += dt;
+        if (!overshooting_) {
+            overshooting_ = true;
+            overshootStart_ = now;
+            metrics_.overshootEvents++;
+        }
+    } else if (overshooting_) {
+        overshooting_ = false;
+        metrics_.lastSettleSec = std::chrono::duration<double>(now - overshootStart_).count();
+        std::cout << "[PowerBudget] Back under " << budgetW_ << "W after "
+                  << metrics_.lastSettleSec << "s" << std::endl;
+    }
+}
+
+} // namespace temper
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "IpmiController.hpp"
+#include <chrono>
+#include <vector>
+
+namespace temper {
+
+struct PowerBudgetMetrics {
+    bool enabled = false;
+    unsigned int budgetW = 0;
+    bool chassisMeasured = false; // Node power from IPMI; otherwise GPUs only
+    double nodePowerW = 0.0;      // Estimated node draw this tick
+    double gpuBudgetW = 0.0;      // Budget left for GPUs after the rest of the node
+    double allocatedW = 0.0;      // Sum of per-GPU limits
+    bool feasible = true;         // false when GPU minimums alone exceed the budget
+    double overshootW = 0.0;      // Current draw above the budget
+    double peakOvershootW = 0.0;
+    double overshootSeconds = 0.0;  // Cumulative time over budget
+    unsigned long long overshootEvents = 0;
+    double lastSettleSec = 0.0;     // Length of the most recent overshoot episode
+};
+
+// Splits a node power budget across GPU power limits every tick.
+//
+// Non-GPU draw is estimated as chassis power (IPMI) minus the GPU sum and
+// smoothed, since IPMI only refreshes every couple of seconds. Each GPU gets
+// its minimum limit, then the remainder is water-filled in proportion to
+// utilization: first up to what each GPU currently wants (power-capped GPUs
+// ask for a step more, the others for their draw plus headroom), then any
+// leftover up to the device maximum. Idle GPUs thereby lend watts to busy ones.
+//
+// Configuration (environment):
+//   NODE_POWER_BUDGET_W     Node budget in W; enables budget mode (replaces POWER_SETPOINTS)
+//   POWER_BUDGET_STEP_W     Per-tick increase for a power-capped GPU (default 10)
+//   POWER_BUDGET_MARGIN_W   Safety margin kept below the budget (default 0)
+class PowerBudget {
+public:
+    PowerBudget();
+
+    struct Demand {
+        unsigned int minW = 0;    // Limit range; equal when the GPU has no power control
+        unsigned int maxW = 0;
+        double drawW = 0.0;
+        unsigned int limitW = 0;  // Limit currently in effect
+        unsigned int util = 0;    // %
+        bool capped = false;      // Running into its power limit
+        bool forceMin = false;    // Thermal fallback: hold at the minimum
+    };
+
+    bool isEnabled() const { return budgetW_ > 0; }
+
+    // Returns one limit (W) per entry in gpus
+    std::vector<unsigned int> allocate(const std::vector<Demand>& gpus, const IpmiMetrics& ipmi);
+
+    PowerBudgetMetrics getMetrics() const { return metrics_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static void waterFill(std::vector<double>& alloc, const std::vector<double>& cap,
+                          const std::vector<double>& weight, double& remaining);
+    void trackOvershoot(Clock::time_point now);
+
+    unsigned int budgetW_ = 0;
+    unsigned int stepW_ = 10;
+    unsigned int marginW_ = 0;
+
+    double nonGpuW_ = 0.0;
+    bool haveNonGpu_ = false;
+    bool overshooting_ = false;
+    Clock::time_point overshootStart_;
+    Clock::time_point lastTick_;
+    PowerBudgetMetrics metrics_;
+};
+
+} // namespace temper
@@ -0,0 +1,113 @@
+#include "ProcessCache.hpp"
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace temper {
+
+ProcessCache::ProcessCache() : useProc_(hostPidNamespace()) {}
+
+bool ProcessCache::hostPidNamespace() {
+    // The initial PID namespace has a fixed inode (PROC_PID_INIT_INO)
+    struct stat st;
+    if (stat("/proc/self/ns/pid", &st) != 0) return true; // Kernel before 3.8: assume shared
+    return st.st_ino == 0xEFFFFFFCu;
+}
+
+bool ProcessCache::lookup(unsigned int pid, ProcessMeta& meta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    if (now - lastSweep_ >= SWEEP_INTERVAL) sweep(now);
+
+    auto it = entries_.find(pid);
+    if (it != entries_.end() && now - it->second.validated < REVALIDATE_INTERVAL) {
+        it->second.lastUsed = now;
+        meta = it->second.meta;
+        return true;
+    }
+
+    // Expired: /proc entries are checked below, externally resolved ones resolved again
+    unsigned long long startTime = 0;
+    if (!useProc_ || !readStartTime(pid, startTime)) {
+        if (it != entries_.end()) entries_.erase(it);
+        return false;
+    }
+
+    if (it == entries_.end() || it->second.meta.startTime != startTime) {
+        // New pid, or the pid was reused by a different process
+        Entry e;
+        e.meta.startTime = startTime;
+        readMeta(pid, e.meta);
+        it = entries_.insert_or_assign(pid, e).first;
+    }
+    it->second.validated = now;
+    it->second.lastUsed = now;
+    meta = it->second.meta;
+    return true;
+}
+
+void ProcessCache::insert(unsigned int pid, const ProcessMeta& meta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    entries_[pid] = {meta, now, now};
+}
+
+size_t ProcessCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool ProcessCache::readStartTime(unsigned int pid, unsigned long long& startTime) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(file, line)) return false;
+
+    // comm (field 2) may contain spaces and parens; fields resume after the last ')'
+    auto close = line.rfind(')');
+    if (close == std::string::npos) return false;
+    std::istringstream iss(line.substr(close + 2));
+    std::string field;
+    // Field 3 (state) is the first token here; starttime is field 22
+    for (int i = 3; i < 22; ++i) {
+        if (!(iss >> field)) return false;
+    }
+    return static_cast<bool>(iss >> startTime);
+}
+
+void ProcessCache::readMeta(unsigned int pid, ProcessMeta& meta) {
+    std::string base = "/proc/" + std::to_string(pid);
+
+    std::ifstream cmdFile(base + "/cmdline", std::ios::binary);
+    std::string raw((std::istreambuf_iterator<char>(cmdFile)), std::istreambuf_iterator<char>());
+    while (!raw.empty() && raw.back() == '\0') raw.pop_back();
+
+    // argv is NUL-separated; name is the basename of argv[0]
+    std::string argv0 = raw.substr(0, raw.find('\0'));
+    for (char& c : raw) {
+        if (c == '\0') c = ' ';
+    }
+    meta.cmdline = raw;
+    meta.name = argv0.substr(argv0.rfind('/') + 1);
+
+    if (meta.name.empty()) {
+        // Kernel threads and zombies have no cmdline
+        std::ifstream commFile(base + "/comm");
+        std::getline(commFile, meta.name);
+    }
+    if (meta.name.empty()) meta.name = "Unknown";
+}
+
+void ProcessCache::sweep(Clock::time_point now) {
+    lastSweep_ = now;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        bool expired = now - it->second.lastUsed >= UNUSED_TTL;
+        if (!expired && it->second.meta.startTime != 0) {
+            struct stat st;
+            expired = stat(("/proc/" + std::to_string(it->first)).c_str(), &st) != 0;
+        }
+        it = expired ? entries_.erase(it) : std::next(it);
+    }
+}
+
+} // namespace temper
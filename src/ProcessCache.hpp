@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace temper {
+
+struct ProcessMeta {
+    std::string name;
+    std::string cmdline;
+    unsigned long long startTime = 0; // Clock ticks since boot (/proc/<pid>/stat field 22), 0 if unknown
+};
+
+// pid -> metadata cache backed by /proc. Entries are revalidated against the
+// process start time so a recycled pid never inherits a stale name, and are
+// dropped once the process exits.
+//
+// The driver reports host pids. Unless we share the host's PID namespace
+// (e.g. docker --pid=host), /proc is never consulted: the same number there
+// would be an unrelated process.
+class ProcessCache {
+public:
+    ProcessCache();
+
+    // Returns false if the pid is not visible in /proc (e.g. no PID namespace
+    // sharing) or its externally resolved entry is due to be resolved again
+    bool lookup(unsigned int pid, ProcessMeta& meta);
+
+    // Caches metadata resolved by other means for a pid that /proc can't see.
+    // It expires like a /proc entry, so a recycled pid is resolved again.
+    void insert(unsigned int pid, const ProcessMeta& meta);
+
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        ProcessMeta meta;
+        Clock::time_point validated;
+        Clock::time_point lastUsed;
+    };
+
+    static constexpr std::chrono::seconds REVALIDATE_INTERVAL{2};
+    static constexpr std::chrono::seconds SWEEP_INTERVAL{10};
+    static constexpr std::chrono::seconds UNUSED_TTL{30};
+
+    static bool hostPidNamespace();
+    static bool readStartTime(unsigned int pid, unsigned long long& startTime);
+    static void readMeta(unsigned int pid, ProcessMeta& meta);
+    void sweep(Clock::time_point now);
+
+    bool useProc_;
+    std::unordered_map<unsigned int, Entry> entries_;
+    Clock::time_point lastSweep_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace temper
@@ -7,9 +7,40 @@
 #include <cstring>
 #include <fcntl.h>
 #include <chrono>
+#include <csignal>
+#include <pthread.h>
+#include <sched.h>
 
 namespace temper {
 
+static sigset_t shutdownSignals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+}
+
+void blockShutdownSignals() {
+    sigset_t signals = shutdownSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+}
+
+// Taken during static initialization, before any thread is pinned
+static cpu_set_t startupAffinity() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &set);
+    }
+    return set;
+}
+static const cpu_set_t g_startupAffinity = startupAffinity();
+
+void resetThreadAffinity() {
+    sched_setaffinity(0, sizeof(g_startupAffinity), &g_startupAffinity);
+}
+
 ProcessResult executeSafe(const std::vector<std::string>& args, int timeoutSec) {
     ProcessResult result = { -1, "", "" };
     
@@ -37,6 +68,12 @@ ProcessResult executeSafe(const std::vector<std::string>& args, int timeoutSec)
         close(pipe_out[0]); close(pipe_out[1]);
         close(pipe_err[0]); close(pipe_err[1]);
 
+        // The mask and affinity survive exec; the command should still stop on
+        // SIGINT/SIGTERM and not run on the real-time loop's CPU
+        sigset_t signals = shutdownSignals();
+        pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+        resetThreadAffinity();
+
         // Make copies of strings to ensure they stay valid
         std::vector<std::vector<char>> arg_storage;
         std::vector<char*> c_args;
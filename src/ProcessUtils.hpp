@@ -21,6 +21,19 @@ struct ProcessResult {
  */
 ProcessResult executeSafe(const std::vector<std::string>& args, int timeoutSec = 30);
 
+/**
+ * Blocks SIGINT and SIGTERM in the calling thread, so they are delivered to
+ * the main thread, which handles shutdown. Call first thing in every thread
+ * the daemon starts.
+ */
+void blockShutdownSignals();
+
+/**
+ * Returns the calling thread to the CPUs the process started on, dropping a
+ * pinning inherited from the real-time loop thread that created it.
+ */
+void resetThreadAffinity();
+
 } // namespace temper
 
 #endif // TEMPER_PROCESS_UTILS_HPP
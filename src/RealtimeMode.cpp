@@ -0,0 +1,147 @@
+#include "RealtimeMode.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sched.h>
+#include <sys/mman.h>
+
+#ifndef MCL_ONFAULT
+#define MCL_ONFAULT 4
+#endif
+
+namespace temper {
+
+RealtimeMode::RealtimeMode() {
+    const char* prioEnv = std::getenv("RT_PRIORITY");
+    if (prioEnv) {
+        status_.requested = true;
+        int minPriority = sched_get_priority_min(SCHED_FIFO);
+        status_.priority = std::clamp(std::atoi(prioEnv), minPriority, sched_get_priority_max(SCHED_FIFO));
+        status_.workerPriority = std::max(minPriority, status_.priority - 1);
+    }
+    const char* cpuEnv = std::getenv("RT_CPU");
+    if (prioEnv && cpuEnv) status_.cpu = std::atoi(cpuEnv);
+}
+
+void RealtimeMode::fail(const std::string& reason) {
+    if (status_.error.empty()) status_.error = reason;
+    else if (status_.error.find(reason) == std::string::npos) status_.error += "; " + reason;
+}
+
+void RealtimeMode::lockMemory() {
+    // Only pages actually touched are locked: locking every thread's full stack
+    // up front would pin hundreds of MB on a many-GPU host
+    int rc = mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+    if (rc != 0 && errno == EINVAL) rc = mlockall(MCL_CURRENT | MCL_FUTURE); // Kernel before 4.4
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rc != 0) {
+        fail(std::string("mlockall: ") + std::strerror(errno));
+        return;
+    }
+    // Fault in the loop thread's stack now rather than during a tick
+    volatile char stack[256 * 1024];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+    status_.memoryLocked = true;
+}
+
+bool RealtimeMode::setFifo(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    if (sched_setscheduler(0, SCHED_FIFO | SCHED_RESET_ON_FORK, &param) != 0) {
+        fail(std::string("SCHED_FIFO: ") + std::strerror(errno));
+        return false;
+    }
+    status_.threads++;
+    return true;
+}
+
+bool RealtimeMode::enterLoopThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (status_.cpu >= CPU_SETSIZE) {
+        fail("RT_CPU " + std::to_string(status_.cpu) + " out of range");
+    } else if (status_.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(status_.cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            fail("RT_CPU " + std::to_string(status_.cpu) + ": " + std::strerror(errno));
+        }
+    }
+    return setFifo(status_.priority);
+}
+
+bool RealtimeMode::enterWorkerThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return setFifo(status_.workerPriority);
+}
+
+void RealtimeMode::selfCheck() {
+    if (status_.requested) {
+        int policy = sched_getscheduler(0) & ~SCHED_RESET_ON_FORK;
+        sched_param param{};
+        sched_getparam(0, &param);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        bool pinned = status_.cpu < 0 || (status_.cpu < CPU_SETSIZE && CPU_COUNT(&set) == 1 && CPU_ISSET(status_.cpu, &set));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.active = policy == SCHED_FIFO && param.sched_priority == status_.priority;
+        if (!pinned) {
+            fail("not pinned to CPU " + std::to_string(status_.cpu));
+            status_.cpu = -1;
+        }
+
+        std::ifstream runtime("/proc/sys/kernel/sched_rt_runtime_us");
+        long runtimeUs = -1;
+        if (runtime >> runtimeUs && runtimeUs >= 0 && status_.active) {
+            std::cout << "[RT] Kernel RT throttling leaves " << runtimeUs << "us/s to SCHED_FIFO threads" << std::endl;
+        }
+    }
+
+    // Wake-up latency of 100 1ms absolute sleeps, comparable between modes
+    using Clock = std::chrono::steady_clock;
+    double sumMs = 0.0, maxMs = 0.0;
+    const int probes = 100;
+    auto deadline = Clock::now();
+    for (int p = 0; p < probes; ++p) {
+        deadline += std::chrono::milliseconds(1);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        timespec ts{(time_t)(ns / 1000000000), (long)(ns % 1000000000)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+        auto now = Clock::now();
+        double lateMs = std::chrono::duration<double, std::milli>(now - deadline).count();
+        sumMs += lateMs;
+        maxMs = std::max(maxMs, lateMs);
+        if (now > deadline) deadline = now;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_.probeAvgMs = sumMs / probes;
+    status_.probeMaxMs = maxMs;
+    if (!status_.requested) {
+        std::cout << "[RT] Normal scheduling; wake-up latency avg " << status_.probeAvgMs << "ms, max " << maxMs << "ms" << std::endl;
+    } else if (status_.active) {
+        std::cout << "[RT] SCHED_FIFO priority " << status_.priority << " on the loop thread"
+                  << (status_.cpu >= 0 ? " (CPU " + std::to_string(status_.cpu) + ")" : "")
+                  << ", " << status_.workerPriority << " on the control workers (" << status_.threads << " thread(s))"
+                  << (status_.memoryLocked ? ", memory locked" : "")
+                  << "; wake-up latency avg " << status_.probeAvgMs << "ms, max " << maxMs << "ms" << std::endl;
+    }
+    if (status_.requested && !status_.error.empty()) {
+        std::cerr << "[RT] " << (status_.active ? "Partly applied: " : "Not applied, running with normal scheduling: ")
+                  << status_.error << std::endl;
+    }
+}
+
+RealtimeStatus RealtimeMode::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+} // namespace temper
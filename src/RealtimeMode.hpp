@@ -0,0 +1,62 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+namespace temper {
+
+struct RealtimeStatus {
+    bool requested = false;    // RT_PRIORITY set
+    bool active = false;       // Self-check passed: SCHED_FIFO at the requested priority
+    int priority = 0;          // Loop thread
+    int workerPriority = 0;    // Control workers, one below the loop
+    int cpu = -1;              // CPU the loop thread is pinned to, -1 if not pinned
+    bool memoryLocked = false;
+    unsigned int threads = 0;  // Threads running SCHED_FIFO
+    double probeAvgMs = 0.0;   // Startup wake-up latency probe, taken in whichever mode is active
+    double probeMaxMs = 0.0;
+    std::string error;         // Why a requested setting did not take, empty if all did
+};
+
+// Opt-in real-time scheduling for the control path.
+//
+// enterLoopThread() moves the loop thread to SCHED_FIFO and pins it to
+// RT_CPU, once the other threads have started. The per-device control
+// workers call enterWorkerThread(): SCHED_FIFO one priority below the loop
+// and not pinned, so they neither preempt the loop nor queue up behind it
+// on one CPU. Both use SCHED_RESET_ON_FORK, so threads and processes they
+// start later run at normal priority; those started by the loop must call
+// resetThreadAffinity() (ProcessUtils) to drop its pinning. The telemetry,
+// HTTP, llama and IPMI threads stay under the normal scheduler. Memory is
+// locked with mlockall so a page fault cannot stall a tick. Any failure
+// (usually missing CAP_SYS_NICE / CAP_IPC_LOCK) is logged and the loop
+// carries on in normal mode.
+//
+// Configuration (environment):
+//   RT_PRIORITY  SCHED_FIFO priority of the loop thread, 1-99 (unset: off)
+//   RT_CPU       CPU to pin the loop thread to (unset: not pinned)
+class RealtimeMode {
+public:
+    RealtimeMode();
+
+    bool isRequested() const { return status_.requested; }
+    // Locks memory; call once from the loop thread before entering it
+    void lockMemory();
+    // false (and the reason recorded) if the policy or pinning was refused
+    bool enterLoopThread();
+    bool enterWorkerThread();
+    // Verifies the calling thread's policy, priority and affinity, probes
+    // wake-up latency for ~100ms and logs the result
+    void selfCheck();
+
+    RealtimeStatus getStatus() const;
+
+private:
+    void fail(const std::string& reason);
+    bool setFifo(int priority);
+
+    mutable std::mutex mutex_; // The enter calls run on several threads
+    RealtimeStatus status_;
+};
+
+} // namespace temper
@@ -0,0 +1,425 @@
+#include "SimulatedBackend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace temper {
+
+std::vector<std::pair<double, double>> SimulatedBackend::parsePairs(const std::string& spec, const char* name) {
+    std::vector<std::pair<double, double>> pairs;
+    std::stringstream ss(spec);
+    std::string token;
+    while (ss >> token) {
+        std::stringstream ts(token);
+        double a, b;
+        char colon;
+        if (ts >> a >> colon >> b && colon == ':' && ts.peek() == EOF) {
+            pairs.emplace_back(a, b);
+        } else {
+            std::cerr << "[Sim] Ignoring malformed " << name << " token: " << token << std::endl;
+        }
+    }
+    return pairs;
+}
+
+SimulatedBackend::SimulatedBackend(unsigned int deviceCount) {
+    if (deviceCount > MAX_DEVICES) deviceCount = MAX_DEVICES;
+
+    const char* wEnv = std::getenv("SIM_WORKLOAD");
+    for (const auto& p : parsePairs(wEnv ? wEnv : "0:10 30:100 90:100 120:10", "SIM_WORKLOAD")) {
+        if (p.first >= 0.0) workload_.emplace_back(p.first, std::clamp(p.second, 0.0, 100.0));
+    }
+    std::stable_sort(workload_.begin(), workload_.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    if (!workload_.empty()) period_ = workload_.back().first;
+
+    const char* sEnv = std::getenv("SIM_SPEED");
+    if (sEnv) speed_ = std::max(0.01, std::atof(sEnv));
+
+    const char* aEnv = std::getenv("SIM_AMBIENT");
+    if (aEnv) ambient_ = std::atof(aEnv);
+
+    start_ = std::chrono::steady_clock::now();
+    devices_.resize(deviceCount);
+    for (unsigned int i = 0; i < deviceCount; ++i) {
+        Device& d = devices_[i];
+        d.fans.resize(FAN_COUNT);
+        d.powerLimit = MAX_POWER_W;
+        d.phaseOffset = i * 3.0;
+        double conductance = CONDUCTANCE_MIN + (CONDUCTANCE_MAX - CONDUCTANCE_MIN) * airflow(d) / 100.0;
+        d.temp = ambient_ + IDLE_POWER_W / conductance;
+        d.power = IDLE_POWER_W;
+        d.lastStep = start_;
+    }
+
+    const char* fEnv = std::getenv("SIM_FAN_FAULT");
+    if (fEnv) {
+        for (const auto& f : parsePairs(fEnv, "SIM_FAN_FAULT")) {
+            if (f.first < 0.0 || f.second < 0.0) continue;
+            size_t gpu = (size_t)f.first, fan = (size_t)f.second;
+            if (gpu < devices_.size() && fan < FAN_COUNT) devices_[gpu].fans[fan].stuck = true;
+        }
+    }
+
+    const char* pEnv = std::getenv("SIM_PCIE_FAULT");
+    if (pEnv) {
+        std::stringstream ss(pEnv);
+        unsigned int index;
+        while (ss >> index) {
+            if (index < devices_.size()) devices_[index].pcieFault = true;
+        }
+    }
+
+    const char* hEnv = std::getenv("SIM_HANG");
+    if (hEnv) {
+        std::string spec(hEnv);
+        std::replace(spec.begin(), spec.end(), ':', ' ');
+        std::stringstream ss(spec);
+        unsigned int index;
+        double at, duration;
+        while (ss >> index >> at >> duration) {
+            if (index < devices_.size()) {
+                devices_[index].hangStart = at;
+                devices_[index].hangEnd = at + duration;
+            }
+        }
+    }
+}
+
+double SimulatedBackend::airflow(const Device& d) {
+    double sum = 0.0;
+    for (const auto& f : d.fans) {
+        if (!f.stuck) sum += f.speed;
+    }
+    return d.fans.empty() ? 0.0 : sum / d.fans.size();
+}
+
+SimulatedBackend::Device& SimulatedBackend::device(nvmlDevice_t handle) const {
+    uintptr_t id = reinterpret_cast<uintptr_t>(handle);
+    if (id == 0 || id > devices_.size()) {
+        throw BackendError("Simulated device lookup failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    Device& d = devices_[id - 1];
+    step(d);
+    return d;
+}
+
+double SimulatedBackend::workloadAt(double t) const {
+    if (workload_.empty()) return 0.0;
+    if (period_ <= 0.0) return workload_.front().second;
+    t = std::fmod(t, period_);
+    if (t <= workload_.front().first) return workload_.front().second;
+    for (size_t i = 1; i < workload_.size(); ++i) {
+        const auto& a = workload_[i - 1];
+        const auto& b = workload_[i];
+        if (t > b.first) continue;
+        return b.first > a.first ? a.second + (b.second - a.second) * (t - a.first) / (b.first - a.first) : b.second;
+    }
+    return workload_.back().second;
+}
+
+// Advance the model to "now" in bounded steps so long gaps between queries stay stable
+void SimulatedBackend::step(Device& d) const {
+    auto now = std::chrono::steady_clock::now();
+    double remaining = std::chrono::duration<double>(now - d.lastStep).count() * speed_;
+    double simNow = std::chrono::duration<double>(now - start_).count() * speed_ + d.phaseOffset;
+    d.lastStep = now;
+
+    while (remaining > 0.0) {
+        double h = std::min(remaining, MAX_STEP_SEC);
+        remaining -= h;
+
+        d.util = workloadAt(simNow - remaining);
+        double demand = IDLE_POWER_W + d.util / 100.0 * (MAX_POWER_W - IDLE_POWER_W);
+        // Dynamic power goes roughly with f^3 (voltage tracks frequency); memory is a smaller share
+        if (d.gpuLockMHz) demand = IDLE_POWER_W + (demand - IDLE_POWER_W) * std::pow((double)d.gpuLockMHz / MAX_GRAPHICS_MHZ, 3);
+        if (d.memLockMHz) demand -= (demand - IDLE_POWER_W) * 0.15 * (1.0 - (double)d.memLockMHz / MAX_MEMORY_MHZ);
+
+        d.throttleReasons = 0;
+        d.power = demand;
+        if (d.power > d.powerLimit) {
+            d.power = d.powerLimit;
+            d.throttleReasons |= nvmlClocksThrottleReasonSwPowerCap;
+        }
+        if (d.temp >= SLOWDOWN_TEMP) {
+            d.power *= 0.7;
+            d.throttleReasons |= nvmlClocksThrottleReasonSwThermalSlowdown;
+        }
+        if (d.util <= 0.0) d.throttleReasons |= nvmlClocksThrottleReasonGpuIdle;
+        if (d.throttleReasons & nvmlClocksThrottleReasonSwPowerCap) d.powerViolationNs += h / speed_ * 1e9;
+        if (d.throttleReasons & nvmlClocksThrottleReasonSwThermalSlowdown) d.thermalViolationNs += h / speed_ * 1e9;
+        d.energy += d.power * h * 1000.0;
+        if (d.pcieFault) d.pcieReplays += d.util / 100.0 * 20.0 * h;
+
+        for (auto& f : d.fans) {
+            if (f.autoFan) {
+                f.target = (unsigned int)std::clamp(30.0 + (d.temp - 40.0) * 1.5, 30.0, 100.0);
+            }
+            f.speed += (f.target - f.speed) * (1.0 - std::exp(-h / FAN_TAU_SEC));
+        }
+
+        double conductance = CONDUCTANCE_MIN + (CONDUCTANCE_MAX - CONDUCTANCE_MIN) * airflow(d) / 100.0;
+        double steadyState = ambient_ + d.power / conductance;
+        d.temp += (steadyState - d.temp) * (1.0 - std::exp(-h / TAU_SEC));
+    }
+}
+
+unsigned int SimulatedBackend::getDeviceCount() const {
+    return devices_.size();
+}
+
+nvmlDevice_t SimulatedBackend::getHandle(unsigned int index) const {
+    if (index >= devices_.size()) {
+        throw BackendError("Get device handle failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    return reinterpret_cast<nvmlDevice_t>(static_cast<uintptr_t>(index + 1));
+}
+
+std::string SimulatedBackend::getUUID(nvmlDevice_t handle) const {
+    char uuid[80];
+    std::snprintf(uuid, sizeof(uuid), "GPU-00000000-0000-0000-0000-%012lu",
+                  (unsigned long)reinterpret_cast<uintptr_t>(handle));
+    return std::string(uuid);
+}
+
+unsigned int SimulatedBackend::getCapabilities(nvmlDevice_t) const {
+    return CAP_TEMPERATURE | CAP_POWER_USAGE | CAP_POWER_LIMIT | CAP_UTILIZATION | CAP_MEMORY | CAP_THROTTLE | CAP_ECC | CAP_MEMORY_TEMP;
+}
+
+SimulatedBackend::CoreReadings SimulatedBackend::readCore(nvmlDevice_t handle, unsigned int wanted) const {
+    uintptr_t id = reinterpret_cast<uintptr_t>(handle);
+    CoreReadings r;
+    if (id == 0 || id > devices_.size()) return r;
+
+    // Injected hang: block outside the lock, as a driver call stuck on one GPU would
+    double remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Device& d = devices_[id - 1];
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        remaining = d.hangStart >= 0.0 && elapsed >= d.hangStart && elapsed < d.hangEnd ? d.hangEnd - elapsed : 0.0;
+    }
+    if (remaining > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+
+    if (wanted & CAP_TEMPERATURE) r.temperature = getTemperature(handle);
+    if (wanted & CAP_POWER_USAGE) r.powerUsage = getPowerUsage(handle);
+    if (wanted & CAP_POWER_LIMIT) r.powerLimit = getPowerLimit(handle);
+    if (wanted & CAP_UTILIZATION) getUtilization(handle, r.utilGpu, r.utilMem);
+    if (wanted & CAP_MEMORY) getMemoryInfo(handle, r.memTotal, r.memUsed);
+    if (wanted & CAP_THROTTLE) r.throttleReasons = getThrottleReasons(handle);
+    r.valid = getCapabilities(handle) & wanted;
+    return r;
+}
+
+unsigned int SimulatedBackend::getTemperature(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned int)std::lround(device(handle).temp);
+}
+
+unsigned int SimulatedBackend::getFanSpeed(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned int)std::lround(device(handle).fans[0].speed);
+}
+
+std::vector<SimulatedBackend::FanInfo> SimulatedBackend::getFans(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FanInfo> fans;
+    for (const auto& f : device(handle).fans) {
+        FanInfo info;
+        info.speed = (unsigned int)std::lround(f.speed);
+        info.target = f.target;
+        info.policy = f.autoFan ? NVML_FAN_POLICY_TEMPERATURE_CONTINOUS_SW : NVML_FAN_POLICY_MANUAL;
+        info.valid = FAN_SPEED | FAN_TARGET | FAN_POLICY | FAN_RPM;
+        info.rpm = f.stuck ? 0 : (unsigned int)(f.speed / 100.0 * FAN_MAX_RPM);
+        fans.push_back(info);
+    }
+    return fans;
+}
+
+unsigned int SimulatedBackend::getPowerUsage(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned int)(device(handle).power * 1000.0); // milliWatts
+}
+
+unsigned int SimulatedBackend::getPowerLimit(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return device(handle).powerLimit * 1000; // milliWatts
+}
+
+void SimulatedBackend::getUtilization(nvmlDevice_t handle, unsigned int& gpu, unsigned int& memory) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    gpu = (unsigned int)d.util;
+    memory = (unsigned int)(d.util * 0.6);
+}
+
+void SimulatedBackend::getMemoryInfo(nvmlDevice_t handle, unsigned long long& total, unsigned long long& used) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    total = 24ULL * 1024 * 1024 * 1024;
+    used = (unsigned long long)(total * (0.2 + 0.6 * d.util / 100.0));
+}
+
+std::string SimulatedBackend::getName(nvmlDevice_t) const {
+    return "Simulated GPU";
+}
+
+SimulatedBackend::Clocks SimulatedBackend::getClocks(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    Clocks c;
+    c.maxGraphics = MAX_GRAPHICS_MHZ;
+    c.maxMemory = MAX_MEMORY_MHZ;
+    c.maxSm = MAX_GRAPHICS_MHZ;
+    c.maxVideo = 1950;
+
+    // Clocks scale roughly with the cube root of the power the board is allowed to draw
+    double demand = IDLE_POWER_W + d.util / 100.0 * (MAX_POWER_W - IDLE_POWER_W);
+    double scale = d.util > 0.0 ? std::cbrt(d.power / demand) : 0.1;
+    c.graphics = (unsigned int)(c.maxGraphics * scale);
+    if (d.gpuLockMHz) c.graphics = std::min(c.graphics, d.gpuLockMHz);
+    c.sm = c.graphics;
+    c.memory = d.util > 0.0 ? c.maxMemory : 405;
+    if (d.memLockMHz) c.memory = d.memLockMHz;
+    c.video = (unsigned int)(c.maxVideo * scale);
+    return c;
+}
+
+SimulatedBackend::PcieInfo SimulatedBackend::getPcieInfo(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    PcieInfo p;
+    p.txThroughput = (unsigned int)(d.util * 100);
+    p.rxThroughput = (unsigned int)(d.util * 500);
+    // Links drop to Gen1 when idle to save power, like real boards
+    p.gen = d.util > 0.0 && !d.pcieFault ? 4 : 1;
+    p.width = d.pcieFault ? 8 : 16;
+    p.maxGen = 4;
+    p.maxWidth = 16;
+    p.replaySupported = true;
+    p.replayCounter = (unsigned int)d.pcieReplays;
+    return p;
+}
+
+SimulatedBackend::EccCounts SimulatedBackend::getEccCounts(nvmlDevice_t) const {
+    return EccCounts();
+}
+
+std::vector<SimulatedBackend::ProcessInfo> SimulatedBackend::getProcesses(nvmlDevice_t) const {
+    return {};
+}
+
+std::string SimulatedBackend::getVbiosVersion(nvmlDevice_t) const {
+    return "00.00.00.00.00";
+}
+
+std::string SimulatedBackend::getSerial(nvmlDevice_t handle) const {
+    return "SIM" + std::to_string(reinterpret_cast<uintptr_t>(handle) - 1);
+}
+
+unsigned int SimulatedBackend::getPowerState(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double util = device(handle).util;
+    if (util >= 50.0) return 0;
+    if (util > 0.0) return 2;
+    return 8;
+}
+
+bool SimulatedBackend::getEnergyConsumption(nvmlDevice_t handle, unsigned long long& millijoules) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    millijoules = (unsigned long long)device(handle).energy;
+    return true;
+}
+
+bool SimulatedBackend::getMemoryTemperature(nvmlDevice_t handle, unsigned int& celsius) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    // GDDR6X-style: memory runs hotter than the core, more so under load
+    celsius = (unsigned int)std::lround(d.temp + 4.0 + d.util * 0.18);
+    return true;
+}
+
+bool SimulatedBackend::getSlowdownTemperature(nvmlDevice_t, unsigned int& celsius) const {
+    celsius = (unsigned int)SLOWDOWN_TEMP;
+    return true;
+}
+
+SimulatedBackend::ViolationTimes SimulatedBackend::getViolationTimes(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Device& d = device(handle);
+    ViolationTimes v;
+    v.supported = true;
+    v.powerNs = (unsigned long long)d.powerViolationNs;
+    v.thermalNs = (unsigned long long)d.thermalViolationNs;
+    return v;
+}
+
+unsigned int SimulatedBackend::getNumFans(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    device(handle);
+    return FAN_COUNT;
+}
+
+void SimulatedBackend::setFanSpeed(nvmlDevice_t handle, unsigned int fan, unsigned int speedPercent) {
+    if (fan >= FAN_COUNT || speedPercent > 100) {
+        throw BackendError("Set fan speed failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Fan& f = device(handle).fans[fan];
+    f.autoFan = false;
+    f.target = speedPercent;
+}
+
+void SimulatedBackend::setPowerLimit(nvmlDevice_t handle, unsigned int watts) {
+    if (watts < MIN_POWER_W || watts > MAX_POWER_W) {
+        throw BackendError("Set power limit failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    device(handle).powerLimit = watts;
+}
+
+void SimulatedBackend::getPowerConstraints(nvmlDevice_t, unsigned int& minW, unsigned int& maxW) const {
+    minW = MIN_POWER_W;
+    maxW = MAX_POWER_W;
+}
+
+void SimulatedBackend::restoreAutoFans(nvmlDevice_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& f : device(handle).fans) f.autoFan = true;
+}
+
+void SimulatedBackend::setGpuLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) {
+    if (minMHz > maxMHz || minMHz < MIN_GRAPHICS_MHZ || maxMHz > MAX_GRAPHICS_MHZ) {
+        throw BackendError("Set GPU locked clocks failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    device(handle).gpuLockMHz = maxMHz;
+}
+
+void SimulatedBackend::setMemoryLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) {
+    if (minMHz > maxMHz || maxMHz > MAX_MEMORY_MHZ) {
+        throw BackendError("Set memory locked clocks failed: Invalid Argument", NVML_ERROR_INVALID_ARGUMENT);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    device(handle).memLockMHz = maxMHz;
+}
+
+void SimulatedBackend::resetLockedClocks(nvmlDevice_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Device& d = device(handle);
+    d.gpuLockMHz = 0;
+    d.memLockMHz = 0;
+}
+
+unsigned long long SimulatedBackend::getThrottleReasons(nvmlDevice_t handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return device(handle).throttleReasons;
+}
+
+} // namespace temper
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Common.hpp"
+#include "GpuBackend.hpp"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace temper {
+
+// Software GPU model for running the control loop without NVIDIA hardware.
+//
+// Each device is a first-order thermal system:
+//   dT/dt = (T_ss - T) / tau,   T_ss = ambient + power / conductance(fan)
+// Power follows a scripted utilization profile and is capped by the power
+// limit; crossing the slowdown temperature engages thermal throttling.
+//
+// Configuration (environment):
+//   SIM_WORKLOAD  "sec:util%" points over one period, repeated (default "0:10 30:100 90:100 120:10")
+//   SIM_SPEED     Simulated seconds per wall-clock second (default 1)
+//   SIM_AMBIENT   Ambient/inlet temperature in C (default 25)
+//   SIM_FAN_FAULT "gpu:fan" pairs of fans stuck at 0 RPM, e.g. "0:1 3:0"
+//   SIM_PCIE_FAULT GPU indices whose link trains at Gen1 x8 and logs replays, e.g. "2 5"
+//   SIM_HANG      "gpu:start:duration" (wall seconds): readCore blocks like a GPU off the bus, e.g. "1:10:20"
+class SimulatedBackend : public GpuBackend {
+public:
+    explicit SimulatedBackend(unsigned int deviceCount);
+
+    // "a:b" tokens of a SIM_* variable; malformed tokens are logged and skipped
+    static std::vector<std::pair<double, double>> parsePairs(const std::string& spec, const char* name);
+
+    SimulatedBackend(const SimulatedBackend&) = delete;
+    SimulatedBackend& operator=(const SimulatedBackend&) = delete;
+
+    unsigned int getDeviceCount() const override;
+    nvmlDevice_t getHandle(unsigned int index) const override;
+    std::string getUUID(nvmlDevice_t handle) const override;
+    unsigned int getCapabilities(nvmlDevice_t handle) const override;
+    CoreReadings readCore(nvmlDevice_t handle, unsigned int wanted) const override;
+
+    unsigned int getTemperature(nvmlDevice_t handle) const override;
+    unsigned int getFanSpeed(nvmlDevice_t handle) const override;
+    std::vector<FanInfo> getFans(nvmlDevice_t handle) const override;
+    unsigned int getPowerUsage(nvmlDevice_t handle) const override;
+    unsigned int getPowerLimit(nvmlDevice_t handle) const override;
+    void getUtilization(nvmlDevice_t handle, unsigned int& gpu, unsigned int& memory) const override;
+    void getMemoryInfo(nvmlDevice_t handle, unsigned long long& total, unsigned long long& used) const override;
+    std::string getName(nvmlDevice_t handle) const override;
+
+    Clocks getClocks(nvmlDevice_t handle) const override;
+    PcieInfo getPcieInfo(nvmlDevice_t handle) const override;
+    EccCounts getEccCounts(nvmlDevice_t handle) const override;
+    std::vector<ProcessInfo> getProcesses(nvmlDevice_t handle) const override;
+    std::string getVbiosVersion(nvmlDevice_t handle) const override;
+    std::string getSerial(nvmlDevice_t handle) const override;
+    unsigned int getPowerState(nvmlDevice_t handle) const override;
+    bool getEnergyConsumption(nvmlDevice_t handle, unsigned long long& millijoules) const override;
+    bool getMemoryTemperature(nvmlDevice_t handle, unsigned int& celsius) const override;
+    bool getSlowdownTemperature(nvmlDevice_t handle, unsigned int& celsius) const override;
+    ViolationTimes getViolationTimes(nvmlDevice_t handle) const override;
+
+    unsigned int getNumFans(nvmlDevice_t handle) const override;
+    void setFanSpeed(nvmlDevice_t handle, unsigned int fan, unsigned int speedPercent) override;
+    void setPowerLimit(nvmlDevice_t handle, unsigned int watts) override;
+    void getPowerConstraints(nvmlDevice_t handle, unsigned int& minW, unsigned int& maxW) const override;
+    void restoreAutoFans(nvmlDevice_t handle) override;
+    void setGpuLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) override;
+    void setMemoryLockedClocks(nvmlDevice_t handle, unsigned int minMHz, unsigned int maxMHz) override;
+    void resetLockedClocks(nvmlDevice_t handle) override;
+    unsigned long long getThrottleReasons(nvmlDevice_t handle) const override;
+
+private:
+    struct Fan {
+        double speed = 30.0;      // % intended (lags the target)
+        unsigned int target = 30; // %
+        bool autoFan = true;
+        bool stuck = false;       // Fault injection: reports its speed but never spins
+    };
+
+    struct Device {
+        double temp = 0.0;           // C
+        std::vector<Fan> fans;
+        double util = 0.0;           // %
+        double power = 0.0;          // W
+        double energy = 0.0;         // mJ since "driver load"
+        double powerViolationNs = 0.0;   // Wall-clock time spent power/thermal capped
+        double thermalViolationNs = 0.0;
+        bool pcieFault = false;          // Fault injection: link trained down, replaying
+        double pcieReplays = 0.0;
+        double hangStart = -1.0;         // Fault injection: wall seconds, -1 for none
+        double hangEnd = -1.0;
+        unsigned int powerLimit = 0; // W
+        unsigned long long throttleReasons = 0;
+        unsigned int gpuLockMHz = 0;  // 0: unlocked
+        unsigned int memLockMHz = 0;
+        double phaseOffset = 0.0;    // s, staggers the workload across devices
+        std::chrono::steady_clock::time_point lastStep;
+    };
+
+    // Thermal and electrical constants shared by all simulated devices
+    static constexpr unsigned int FAN_COUNT = 2;
+    static constexpr unsigned int MIN_POWER_W = 100;
+    static constexpr unsigned int MAX_POWER_W = 350;
+    static constexpr double IDLE_POWER_W = 30.0;
+    static constexpr double TAU_SEC = 20.0;          // Thermal time constant
+    static constexpr double CONDUCTANCE_MIN = 3.0;   // W/C at 0% fan
+    static constexpr double CONDUCTANCE_MAX = 12.0;  // W/C at 100% fan
+    static constexpr double FAN_TAU_SEC = 1.5;       // Fan spin-up/down lag
+    static constexpr unsigned int FAN_MAX_RPM = 3000;
+    static constexpr unsigned int MAX_GRAPHICS_MHZ = 2100;
+    static constexpr unsigned int MAX_MEMORY_MHZ = 9751;
+    static constexpr unsigned int MIN_GRAPHICS_MHZ = 210;
+    static constexpr double SLOWDOWN_TEMP = 90.0;
+    static constexpr double MAX_STEP_SEC = 0.5;      // Integration step cap
+
+    Device& device(nvmlDevice_t handle) const;
+    void step(Device& d) const;
+    double workloadAt(double t) const;
+    static double airflow(const Device& d); // Mean effective fan speed in %
+
+    mutable std::vector<Device> devices_;
+    mutable std::mutex mutex_;
+    std::vector<std::pair<double, double>> workload_; // (seconds, util%), sorted by time
+    double period_ = 0.0;
+    double speed_ = 1.0;
+    double ambient_ = 25.0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace temper
@@ -0,0 +1,277 @@
+#include "TelemetryCollector.hpp"
+#include <cstdlib>
+
+namespace temper {
+
+static std::chrono::milliseconds envMs(const char* name, unsigned long fallback) {
+    const char* env = std::getenv(name);
+    return std::chrono::milliseconds(env ? std::strtoul(env, nullptr, 10) : fallback);
+}
+
+TelemetryCollector::TelemetryCollector(GpuBackend& nvml, EnergyMeter& energy, ThrottleMeter& throttle, PcieMonitor& pcie,
+                                       FanMonitor& fans, const std::vector<nvmlDevice_t>& handles,
+                                       const std::vector<std::string>& uuids)
+    : nvml_(nvml), energy_(energy), throttle_(throttle), pcie_(pcie), fans_(fans), handles_(handles), uuids_(uuids),
+      devices_(handles.size()) {
+    intervals_[SAMPLES] = envMs("TELEMETRY_SAMPLES_MS", 1000);
+    intervals_[LINKS] = envMs("TELEMETRY_LINKS_MS", 1000);
+    intervals_[ECC] = envMs("TELEMETRY_ECC_MS", 5000);
+    intervals_[PROCESSES] = envMs("TELEMETRY_PROCESSES_MS", 2000);
+}
+
+bool TelemetryCollector::due(unsigned int device) const {
+    const Device& d = devices_[device];
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (int g = 0; g < GROUP_COUNT; ++g) {
+        if (!d.collected[g] || now - d.collectedAt[g] >= intervals_[g]) return true;
+    }
+    return false;
+}
+
+void TelemetryCollector::collect(unsigned int device, const GpuMetrics& control) {
+    Device& d = devices_[device];
+    std::array<bool, GROUP_COUNT> pending{};
+    {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        for (int g = 0; g < GROUP_COUNT; ++g) pending[g] = !d.collected[g] || now - d.collectedAt[g] >= intervals_[g];
+    }
+
+    auto handle = handles_[device];
+    GpuMetrics m{};
+    if (pending[SAMPLES]) {
+        auto core = nvml_.readCore(handle, GpuBackend::CAP_UTILIZATION | GpuBackend::CAP_MEMORY | GpuBackend::CAP_POWER_LIMIT);
+        m.present = core.valid;
+        m.utilGpu = core.utilGpu;
+        m.utilMem = core.utilMem;
+        m.memTotal = core.memTotal;
+        m.memUsed = core.memUsed;
+        m.powerLimit = core.powerLimit;
+        m.memTempSupported = nvml_.getMemoryTemperature(handle, m.memTemp);
+
+        // Stall detection compares against what the control loop commanded
+        auto fans = nvml_.getFans(handle);
+        m.fanSpeed = fans.empty() ? 0 : fans[0].speed;
+        for (unsigned int f = 0; f < fans.size(); ++f) {
+            unsigned int commanded = f < control.fanTargets.size() ? control.fanTargets[f] : control.targetFan;
+            bool stalled = fans_.update(device, f, commanded, fans[f]);
+            m.fans.push_back({f, fans[f].speed, fans[f].target, commanded, fans[f].valid, fans[f].rpm,
+                              fans[f].policy == NVML_FAN_POLICY_MANUAL, stalled});
+        }
+
+        m.pState = nvml_.getPowerState(handle);
+        switch(m.pState) {
+            case 0: m.pStateDescription = "Maximum Performance"; break;
+            case 1: m.pStateDescription = "Performance"; break;
+            case 2: m.pStateDescription = "Balanced"; break;
+            case 5: m.pStateDescription = "Compute/Video"; break;
+            case 8: m.pStateDescription = "Idle/Low Power"; break;
+            case 15: m.pStateDescription = "Minimum Power"; break;
+            default: m.pStateDescription = "Unknown"; break;
+        }
+
+        // Samples since the last collection; fall back to the point readings when the buffer is empty
+        auto windows = nvml_.drainSamples(handle);
+        m.sampleCount = windows.gpuUtil.count;
+        m.utilGpuAvg = windows.gpuUtil.count ? windows.gpuUtil.average : m.utilGpu;
+        m.utilGpuPeak = windows.gpuUtil.count ? windows.gpuUtil.peak : m.utilGpu;
+        m.utilMemAvg = windows.memUtil.count ? windows.memUtil.average : m.utilMem;
+        m.utilMemPeak = windows.memUtil.count ? windows.memUtil.peak : m.utilMem;
+        m.powerAvg = windows.power.count ? windows.power.average : control.powerUsage;
+        m.powerPeak = windows.power.count ? windows.power.peak : control.powerUsage;
+        if (windows.gpuUtil.count) {
+            m.dutyCycle = 100.0 * windows.gpuUtil.nonZero / windows.gpuUtil.count;
+        } else {
+            m.dutyCycle = m.utilGpu > 0 ? 100.0 : 0.0;
+        }
+        // Energy: hardware counter where available, else integrate the sampled power
+        const std::string& uuid = uuids_[device];
+        unsigned long long energyMj = 0;
+        if (nvml_.getEnergyConsumption(handle, energyMj)) {
+            energy_.updateCounter(uuid, energyMj);
+        } else {
+            energy_.updatePower(uuid, m.powerAvg);
+        }
+        m.energyJoules = energy_.getJoules(uuid);
+        m.energyAvgPowerW = energy_.getWindowAvgPowerW(uuid);
+        m.energyWindowSec = energy_.getWindowSec();
+        m.energyExact = energy_.isExact(uuid);
+
+        auto clocks = nvml_.getClocks(handle);
+        m.clockGraphics = clocks.graphics;
+        m.clockMemory = clocks.memory;
+        m.clockSm = clocks.sm;
+        m.clockVideo = clocks.video;
+        m.maxClockGraphics = clocks.maxGraphics;
+        m.maxClockMemory = clocks.maxMemory;
+        m.maxClockSm = clocks.maxSm;
+        m.maxClockVideo = clocks.maxVideo;
+
+        // Violation counters cover the whole interval; the reason bitmask is the control loop's latest
+        unsigned long long reasons = control.throttleReasonsBitmask;
+        bool busy = m.utilGpu > 0 && !(reasons & nvmlClocksThrottleReasonGpuIdle);
+        m.throttle = throttle_.update(device, nvml_.getViolationTimes(handle), reasons, clocks.sm, clocks.maxSm, busy);
+    }
+
+    if (pending[LINKS]) {
+        unsigned int util = m.utilGpu;
+        if (!pending[SAMPLES]) {
+            std::lock_guard<std::mutex> lock(d.mutex);
+            util = d.metrics.utilGpu;
+        }
+        auto pcie = nvml_.getPcieInfo(handle);
+        m.pcieTx = pcie.txThroughput;
+        m.pcieRx = pcie.rxThroughput;
+        m.pcieGen = pcie.gen;
+        m.pcieWidth = pcie.width;
+        m.pcieMaxGen = pcie.maxGen;
+        m.pcieMaxWidth = pcie.maxWidth;
+        m.pcieReplaySupported = pcie.replaySupported;
+        m.pcieReplayCounter = pcie.replayCounter;
+        PcieStatus pcieStatus = pcie_.update(device, pcie, util > 0);
+        m.pcieReplaysPerSec = pcieStatus.replaysPerSec;
+        m.pcieDegraded = pcieStatus.degraded;
+        m.pcieDegradedEvents = pcieStatus.degradedEvents;
+
+        for (const auto& l : nvml_.getNvLinks(handle)) {
+            m.nvlinks.push_back({l.link, l.active, l.version, l.remoteBusId, l.txKBps, l.rxKBps,
+                                 l.crcFlitErrors, l.crcDataErrors, l.replayErrors, l.recoveryErrors, l.errorsPerSec});
+            m.nvlinkTxKBps += l.txKBps;
+            m.nvlinkRxKBps += l.rxKBps;
+        }
+    }
+
+    if (pending[ECC]) {
+        auto ecc = nvml_.getEccCounts(handle);
+        m.eccVolatileSingle = ecc.volatileSingle;
+        m.eccVolatileDouble = ecc.volatileDouble;
+        m.eccAggregateSingle = ecc.aggregateSingle;
+        m.eccAggregateDouble = ecc.aggregateDouble;
+    }
+
+    if (pending[PROCESSES]) {
+        auto procs = nvml_.getProcesses(handle);
+        for (const auto& p : procs) {
+            m.processes.push_back({p.pid, p.usedMemory, p.name, p.cmdline, p.smUtil, p.memUtil, p.encUtil, p.decUtil});
+        }
+
+        // MIG slices, with processes attributed by GPU/compute instance id
+        for (const auto& gi : nvml_.getMigInstances(handle)) {
+            MigInstanceMetrics im{gi.id, gi.sliceCount, gi.memTotal, gi.memUsed, gi.utilSupported, gi.smUtil, gi.memBwUtil, {}};
+            for (const auto& ci : gi.computeInstances) {
+                MigComputeInstanceMetrics cm{ci.id, ci.uuid, ci.sliceCount, ci.multiprocessorCount, {}};
+                for (const auto& p : procs) {
+                    if (p.gpuInstanceId != gi.id || p.computeInstanceId != ci.id) continue;
+                    cm.processes.push_back({p.pid, p.usedMemory, p.name, p.cmdline, p.smUtil, p.memUtil, p.encUtil, p.decUtil});
+                }
+                im.computeInstances.push_back(std::move(cm));
+            }
+            m.migInstances.push_back(std::move(im));
+        }
+    }
+
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (int g = 0; g < GROUP_COUNT; ++g) {
+        if (!pending[g]) continue;
+        copyGroup((Group)g, m, d.metrics);
+        d.collected[g] = true;
+        d.collectedAt[g] = now;
+    }
+    if (pending[SAMPLES]) {
+        d.metrics.powerLimit = m.powerLimit;
+        d.metrics.memTemp = m.memTemp;
+        d.metrics.memTempSupported = m.memTempSupported;
+    }
+}
+
+void TelemetryCollector::merge(GpuMetrics& m) const {
+    if (m.index >= devices_.size()) return;
+    const Device& d = devices_[m.index];
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (int g = 0; g < GROUP_COUNT; ++g) copyGroup((Group)g, d.metrics, m);
+    // The control loop's own readings are fresher where it took them
+    if (!m.powerLimit) m.powerLimit = d.metrics.powerLimit;
+    if (!m.memTempSupported) {
+        m.memTemp = d.metrics.memTemp;
+        m.memTempSupported = d.metrics.memTempSupported;
+    }
+    auto age = [&](Group g) {
+        return d.collected[g] ? std::chrono::duration<double>(now - d.collectedAt[g]).count() : -1.0;
+    };
+    m.samplesAgeSec = age(SAMPLES);
+    m.linksAgeSec = age(LINKS);
+    m.eccAgeSec = age(ECC);
+    m.processesAgeSec = age(PROCESSES);
+}
+
+void TelemetryCollector::copyGroup(Group group, const GpuMetrics& from, GpuMetrics& to) {
+    switch (group) {
+        case SAMPLES: {
+            const unsigned int bits = GpuBackend::CAP_UTILIZATION | GpuBackend::CAP_MEMORY;
+            to.present = (to.present & ~bits) | (from.present & bits);
+            to.utilGpu = from.utilGpu;
+            to.utilMem = from.utilMem;
+            to.memTotal = from.memTotal;
+            to.memUsed = from.memUsed;
+            to.fanSpeed = from.fanSpeed;
+            to.fans = from.fans;
+            to.pState = from.pState;
+            to.pStateDescription = from.pStateDescription;
+            to.sampleCount = from.sampleCount;
+            to.utilGpuAvg = from.utilGpuAvg;
+            to.utilGpuPeak = from.utilGpuPeak;
+            to.utilMemAvg = from.utilMemAvg;
+            to.utilMemPeak = from.utilMemPeak;
+            to.powerAvg = from.powerAvg;
+            to.powerPeak = from.powerPeak;
+            to.dutyCycle = from.dutyCycle;
+            to.energyJoules = from.energyJoules;
+            to.energyAvgPowerW = from.energyAvgPowerW;
+            to.energyWindowSec = from.energyWindowSec;
+            to.energyExact = from.energyExact;
+            to.clockGraphics = from.clockGraphics;
+            to.clockMemory = from.clockMemory;
+            to.clockSm = from.clockSm;
+            to.clockVideo = from.clockVideo;
+            to.maxClockGraphics = from.maxClockGraphics;
+            to.maxClockMemory = from.maxClockMemory;
+            to.maxClockSm = from.maxClockSm;
+            to.maxClockVideo = from.maxClockVideo;
+            to.throttle = from.throttle;
+            break;
+        }
+        case LINKS:
+            to.pcieTx = from.pcieTx;
+            to.pcieRx = from.pcieRx;
+            to.pcieGen = from.pcieGen;
+            to.pcieWidth = from.pcieWidth;
+            to.pcieMaxGen = from.pcieMaxGen;
+            to.pcieMaxWidth = from.pcieMaxWidth;
+            to.pcieReplaySupported = from.pcieReplaySupported;
+            to.pcieReplayCounter = from.pcieReplayCounter;
+            to.pcieReplaysPerSec = from.pcieReplaysPerSec;
+            to.pcieDegraded = from.pcieDegraded;
+            to.pcieDegradedEvents = from.pcieDegradedEvents;
+            to.nvlinks = from.nvlinks;
+            to.nvlinkTxKBps = from.nvlinkTxKBps;
+            to.nvlinkRxKBps = from.nvlinkRxKBps;
+            break;
+        case ECC:
+            to.eccVolatileSingle = from.eccVolatileSingle;
+            to.eccVolatileDouble = from.eccVolatileDouble;
+            to.eccAggregateSingle = from.eccAggregateSingle;
+            to.eccAggregateDouble = from.eccAggregateDouble;
+            break;
+        case PROCESSES:
+            to.processes = from.processes;
+            to.migInstances = from.migInstances;
+            break;
+        case GROUP_COUNT:
+            break;
+    }
+}
+
+} // namespace temper
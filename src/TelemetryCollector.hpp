@@ -0,0 +1,71 @@
+#pragma once
+
+#include "EnergyMeter.hpp"
+#include "FanMonitor.hpp"
+#include "GpuBackend.hpp"
+#include "MetricServer.hpp"
+#include "PcieMonitor.hpp"
+#include "ThrottleMeter.hpp"
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace temper {
+
+// The slow half of a GPU's metrics, collected apart from the control loop.
+//
+// Each metric group has its own interval and is collected by the device's
+// telemetry worker; results are kept per device and merged into the control
+// loop's readings whenever a snapshot is published. The control loop reads
+// only temperature, throttle reasons and power draw, so fan readings, process
+// scans, ECC and link queries (and the JSON build) never delay fan and power
+// control, however long they take.
+//
+// Configuration (environment), intervals in milliseconds:
+//   TELEMETRY_SAMPLES_MS    Utilization, memory, fans, memory temperature, sample buffers,
+//                           energy, clocks, P-state, throttle time (default 1000)
+//   TELEMETRY_LINKS_MS      PCIe and NVLink (default 1000)
+//   TELEMETRY_ECC_MS        ECC counters (default 5000)
+//   TELEMETRY_PROCESSES_MS  Processes and MIG instances (default 2000)
+class TelemetryCollector {
+public:
+    enum Group { SAMPLES, LINKS, ECC, PROCESSES, GROUP_COUNT };
+
+    TelemetryCollector(GpuBackend& nvml, EnergyMeter& energy, ThrottleMeter& throttle, PcieMonitor& pcie, FanMonitor& fans,
+                       const std::vector<nvmlDevice_t>& handles, const std::vector<std::string>& uuids);
+
+    // Whether any group of the device is due
+    bool due(unsigned int device) const;
+    // Collects the due groups. Runs on the device's telemetry worker; `control`
+    // is the latest control reading of the device (throttle reasons, fan targets).
+    void collect(unsigned int device, const GpuMetrics& control);
+    // Fills m's telemetry fields from the latest results (zero until first collected)
+    void merge(GpuMetrics& m) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Device {
+        mutable std::mutex mutex; // collect() stores while the publisher merges
+        GpuMetrics metrics{};
+        std::array<bool, GROUP_COUNT> collected{};
+        std::array<Clock::time_point, GROUP_COUNT> collectedAt{};
+    };
+
+    static void copyGroup(Group group, const GpuMetrics& from, GpuMetrics& to);
+
+    GpuBackend& nvml_;
+    EnergyMeter& energy_;
+    ThrottleMeter& throttle_;
+    PcieMonitor& pcie_;
+    FanMonitor& fans_;
+    std::vector<nvmlDevice_t> handles_;
+    std::vector<std::string> uuids_;
+    std::array<Clock::duration, GROUP_COUNT> intervals_;
+    std::deque<Device> devices_; // Sized once; never resized, so entries need no map lock
+};
+
+} // namespace temper
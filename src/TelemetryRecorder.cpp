@@ -0,0 +1,57 @@
+#include "TelemetryRecorder.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace temper {
+
+TelemetryRecorder::TelemetryRecorder() {
+    const char* path = std::getenv("TELEMETRY_RECORD");
+    if (!path) return;
+
+    const char* sEnv = std::getenv("TELEMETRY_RECORD_SEC");
+    if (sEnv) intervalSec_ = std::max(0.1, std::atof(sEnv));
+
+    out_.open(path, std::ios::app);
+    if (!out_) {
+        std::cerr << "[Record] Cannot open " << path << "; telemetry is not recorded" << std::endl;
+        return;
+    }
+    out_.seekp(0, std::ios::end);
+    if (out_.tellp() == 0) {
+        out_ << "time,gpu,uuid,temp_c,fan_pct,power_w,util_pct,thermal_throttle_sec,slowdown_c\n";
+    }
+    std::cout << "[Record] Appending telemetry to " << path << " every " << intervalSec_ << "s" << std::endl;
+}
+
+void TelemetryRecorder::record(const std::vector<GpuMetrics>& metrics, const std::vector<std::string>& uuids,
+                               const std::vector<unsigned int>& slowdownTemps) {
+    if (!isEnabled()) return;
+    auto now = Clock::now();
+    if (started_ && now - last_ < std::chrono::duration<double>(intervalSec_)) return;
+    started_ = true;
+    last_ = now;
+
+    double unixTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const auto& m : metrics) {
+        // Stale readings would replay as a flat line; a temperature-less GPU has nothing to fit
+        if (!m.responsive || !(m.present & GpuBackend::CAP_TEMPERATURE) || m.index >= uuids.size()) continue;
+        // Reported speeds where the driver has them, else what was commanded
+        double fan = 0.0;
+        unsigned int reported = 0;
+        for (const auto& f : m.fans) {
+            if (!(f.valid & GpuBackend::FAN_SPEED)) continue;
+            fan += f.speed;
+            reported++;
+        }
+        fan = reported ? fan / reported : m.targetFan;
+        out_ << std::fixed << std::setprecision(3) << unixTime << ',' << m.index << ',' << uuids[m.index] << ','
+             << m.temp << ',' << std::setprecision(1) << fan << ',' << m.powerUsage / 1000.0 << ','
+             << m.utilGpu << ',' << std::setprecision(3) << m.throttle.thermalSec << ','
+             << (m.index < slowdownTemps.size() ? slowdownTemps[m.index] : 0) << '\n';
+    }
+    out_.flush();
+}
+
+} // namespace temper
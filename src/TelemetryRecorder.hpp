@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MetricServer.hpp"
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace temper {
+
+// Appends per-GPU telemetry to a CSV file, the input of `temper tune`.
+//
+// One row per responsive GPU per interval:
+//   time,gpu,uuid,temp_c,fan_pct,power_w,util_pct,thermal_throttle_sec,slowdown_c
+// time is Unix seconds; thermal_throttle_sec is the cumulative ThrottleMeter
+// counter (diff consecutive rows for the interval); slowdown_c 0 is unknown.
+//
+// Configuration (environment):
+//   TELEMETRY_RECORD      Output path (unset: off). Appended to; the header is written to empty files.
+//   TELEMETRY_RECORD_SEC  Row interval per GPU (default 1)
+class TelemetryRecorder {
+public:
+    TelemetryRecorder();
+
+    bool isEnabled() const { return out_.is_open(); }
+    void record(const std::vector<GpuMetrics>& metrics, const std::vector<std::string>& uuids,
+                const std::vector<unsigned int>& slowdownTemps);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::ofstream out_;
+    double intervalSec_ = 1.0;
+    bool started_ = false;
+    Clock::time_point last_;
+};
+
+} // namespace temper
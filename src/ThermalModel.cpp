@@ -0,0 +1,112 @@
+#include "ThermalModel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace temper {
+
+ThermalModel::ThermalModel() {
+    const char* hEnv = std::getenv("THERMAL_HORIZON_SEC");
+    if (hEnv) horizonSec_ = std::max(0.0, std::atof(hEnv));
+
+    const char* sEnv = std::getenv("MODEL_SAMPLE_SEC");
+    if (sEnv) sampleSec_ = std::max(0.1, std::atof(sEnv));
+
+    const char* fEnv = std::getenv("MODEL_FORGET");
+    if (fEnv) forget_ = std::clamp(std::atof(fEnv), 0.9, 1.0);
+}
+
+ThermalModel::State& ThermalModel::state(unsigned int device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return states_[device];
+}
+
+// Scaled so every term is of order 1, which keeps the fit well conditioned
+ThermalModel::Vec ThermalModel::regressors(double tempC, double powerW, double fanPercent, double inletC) {
+    double rise = tempC - std::max(0.0, inletC);
+    return {powerW / 100.0, rise / 10.0, fanPercent * rise / 1000.0, fanPercent / 100.0, 1.0};
+}
+
+void ThermalModel::fit(State& s, const Vec& x, double y) {
+    Vec px{};
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) px[i] += s.p[i][j] * x[j];
+    }
+    double denom = forget_;
+    for (int i = 0; i < N; ++i) denom += x[i] * px[i];
+
+    double err = y;
+    for (int i = 0; i < N; ++i) err -= s.theta[i] * x[i];
+    for (int i = 0; i < N; ++i) s.theta[i] += px[i] / denom * err;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) s.p[i][j] = (s.p[i][j] - px[i] * px[j] / denom) / forget_;
+    }
+}
+
+void ThermalModel::forecast(State& s, double tempC, double powerW, double fanPercent, double inletC, double slowdownC) {
+    ThermalPrediction& pr = s.prediction;
+    const Vec& t = s.theta;
+    double inlet = std::max(0.0, inletC);
+
+    // Holding power and fan: dT/dt = -k (T - Tss)
+    double k = -(t[1] / 10.0 + t[2] * fanPercent / 1000.0);
+    double drive = t[0] * powerW / 100.0 + t[3] * fanPercent / 100.0 + t[4];
+    pr.ready = pr.samples >= 60 && k > 1e-4;
+    if (!pr.ready) {
+        pr.predictedC = tempC;
+        pr.timeToThrottleSec = -1.0;
+        return;
+    }
+
+    pr.timeConstantSec = 1.0 / k;
+    pr.steadyStateC = inlet + drive / k;
+    pr.predictedC = pr.steadyStateC + (tempC - pr.steadyStateC) * std::exp(-k * horizonSec_);
+
+    if (slowdownC <= 0.0 || pr.steadyStateC <= slowdownC) pr.timeToThrottleSec = -1.0;
+    else if (tempC >= slowdownC) pr.timeToThrottleSec = 0.0;
+    else pr.timeToThrottleSec = std::log((pr.steadyStateC - tempC) / (pr.steadyStateC - slowdownC)) / k;
+}
+
+ThermalPrediction ThermalModel::update(unsigned int device, double tempC, double powerW, double fanPercent,
+                                       double inletC, double slowdownC) {
+    State& s = state(device);
+    ThermalPrediction& pr = s.prediction;
+    auto now = Clock::now();
+    pr.horizonSec = horizonSec_;
+
+    if (!s.started) {
+        s.started = true;
+        for (int i = 0; i < N; ++i) s.p[i][i] = 1000.0;
+    } else {
+        double dt = std::chrono::duration<double>(now - s.lastSample).count();
+        if (dt < sampleSec_) return pr;
+        fit(s, s.lastX, (tempC - s.lastTemp) / dt);
+        pr.samples++;
+    }
+    s.lastX = regressors(tempC, powerW, fanPercent, inletC);
+    s.lastTemp = tempC;
+    s.lastSample = now;
+
+    // Score forecasts that have come due against what actually happened
+    while (!s.pending.empty() && s.pending.front().due <= now) {
+        pr.lastErrorC = tempC - s.pending.front().tempC;
+        pr.meanAbsErrorC += 0.1 * (std::fabs(pr.lastErrorC) - pr.meanAbsErrorC);
+        s.pending.pop_front();
+    }
+
+    forecast(s, tempC, powerW, fanPercent, inletC, slowdownC);
+    if (pr.ready) {
+        s.pending.push_back({now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(horizonSec_)),
+                             pr.predictedC});
+    }
+    return pr;
+}
+
+double ThermalModel::predicted(unsigned int device, double fallback) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(device);
+    if (it == states_.end() || !it->second.prediction.ready) return fallback;
+    return it->second.prediction.predictedC;
+}
+
+} // namespace temper
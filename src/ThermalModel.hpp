@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace temper {
+
+struct ThermalPrediction {
+    bool ready = false;            // Enough samples and a stable fit
+    unsigned long long samples = 0;
+    double timeConstantSec = 0.0;  // At the current fan speed
+    double steadyStateC = 0.0;     // Where the temperature settles at current power and fan
+    double predictedC = 0.0;       // Temperature horizonSec from now
+    double horizonSec = 0.0;
+    double timeToThrottleSec = -1.0; // -1: not heading for the slowdown temperature (or unknown)
+    double lastErrorC = 0.0;       // Actual minus the forecast made horizonSec earlier
+    double meanAbsErrorC = 0.0;    // EMA of |lastErrorC|
+};
+
+// Online first-order thermal model per GPU, for feed-forward fan control.
+//
+//   dT/dt = a*P + (b + c*fan)*(T - Tin) + d*fan + e
+//
+// is fitted by recursive least squares (with forgetting, so it tracks dust,
+// ambient and fan wear) from power draw, fan speed, inlet and core
+// temperature, sampled every MODEL_SAMPLE_SEC. Holding power and fan, the
+// solution is an exponential approach to a steady state. That gives the
+// temperature THERMAL_HORIZON_SEC ahead and the time until the slowdown
+// threshold is reached. Each forecast is scored against the temperature
+// actually reached.
+//
+// Configuration (environment):
+//   THERMAL_HORIZON_SEC  Forecast horizon (default 10)
+//   MODEL_SAMPLE_SEC     Fit interval (default 1)
+//   MODEL_FORGET         RLS forgetting factor per sample (default 0.998)
+class ThermalModel {
+public:
+    static constexpr int N = 5;
+    using Vec = std::array<double, N>;
+
+    ThermalModel();
+
+    // One observation per tick (fits at most every MODEL_SAMPLE_SEC). inletC <= 0 means
+    // unknown; the constant terms then absorb it. slowdownC 0: threshold unknown.
+    ThermalPrediction update(unsigned int device, double tempC, double powerW, double fanPercent,
+                             double inletC, double slowdownC);
+    // Latest forecast horizonSec ahead, or `fallback` until the model is ready
+    double predicted(unsigned int device, double fallback) const;
+
+    double getHorizonSec() const { return horizonSec_; }
+
+    // Model inputs for one sample; dT/dt = theta . regressors (also fitted offline by CurveTuner)
+    static Vec regressors(double tempC, double powerW, double fanPercent, double inletC);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Forecast {
+        Clock::time_point due;
+        double tempC;
+    };
+
+    struct State {
+        bool started = false;
+        Vec theta{};
+        std::array<Vec, N> p{};     // Inverse correlation matrix
+        double lastTemp = 0.0;
+        Vec lastX{};
+        Clock::time_point lastSample;
+        std::deque<Forecast> pending; // Forecasts waiting for their due time
+        ThermalPrediction prediction;
+    };
+
+    State& state(unsigned int device);
+    void fit(State& s, const Vec& x, double y);
+    void forecast(State& s, double tempC, double powerW, double fanPercent, double inletC, double slowdownC);
+
+    double horizonSec_ = 10.0;
+    double sampleSec_ = 1.0;
+    double forget_ = 0.998;
+
+    mutable std::mutex mutex_; // Guards the map only; each entry belongs to one device's poller
+    std::map<unsigned int, State> states_;
+};
+
+} // namespace temper
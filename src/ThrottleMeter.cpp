@@ -0,0 +1,73 @@
+#include "ThrottleMeter.hpp"
+#include <algorithm>
+
+namespace temper {
+
+// Seconds a counter advanced, bounded by the interval (counters restart on driver reload)
+static double counterSec(unsigned long long now, unsigned long long prev, double dt) {
+    if (now < prev) return 0.0;
+    return std::min(dt, (now - prev) / 1e9);
+}
+
+ThrottleStats ThrottleMeter::update(unsigned int device, const GpuBackend::ViolationTimes& violations,
+                                    unsigned long long reasons, unsigned int smClock, unsigned int maxSmClock, bool busy) {
+    State* entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry = &states_[device];
+    }
+    State& s = *entry;
+    auto now = Clock::now();
+    ThrottleStats& st = s.stats;
+
+    st.exact = violations.supported;
+    st.clockDeficitPercent = busy && maxSmClock > 0 && smClock < maxSmClock ? 100.0 * (maxSmClock - smClock) / maxSmClock : 0.0;
+
+    if (!s.started) {
+        s.started = true;
+        s.last = violations;
+        s.lastUpdate = now;
+        return st;
+    }
+
+    double dt = std::chrono::duration<double>(now - s.lastUpdate).count();
+    s.lastUpdate = now;
+
+    double power, thermal, syncBoost, reliability;
+    if (violations.supported) {
+        power = counterSec(violations.powerNs, s.last.powerNs, dt);
+        thermal = counterSec(violations.thermalNs, s.last.thermalNs, dt);
+        syncBoost = counterSec(violations.syncBoostNs, s.last.syncBoostNs, dt);
+        reliability = counterSec(violations.reliabilityNs, s.last.reliabilityNs, dt);
+    } else {
+        power = reasons & (nvmlClocksThrottleReasonSwPowerCap | nvmlClocksThrottleReasonHwPowerBrakeSlowdown) ? dt : 0.0;
+        thermal = reasons & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwThermalSlowdown |
+                             nvmlClocksThrottleReasonHwSlowdown) ? dt : 0.0;
+        syncBoost = reasons & nvmlClocksThrottleReasonSyncBoost ? dt : 0.0;
+        reliability = 0.0; // Not represented in the bitmask
+    }
+    s.last = violations;
+
+    st.powerSec += power;
+    st.thermalSec += thermal;
+    st.syncBoostSec += syncBoost;
+    st.reliabilitySec += reliability;
+
+    if (!busy || dt <= 0.0) return st;
+    st.busySec += dt;
+
+    double lost = dt * st.clockDeficitPercent / 100.0;
+    st.lostTotalSec += lost;
+
+    // Overlapping causes share the loss; uncovered time goes to "other"
+    double active = power + thermal + syncBoost + reliability;
+    double scale = active > dt ? active : dt;
+    st.lostPowerSec += lost * power / scale;
+    st.lostThermalSec += lost * thermal / scale;
+    st.lostSyncBoostSec += lost * syncBoost / scale;
+    st.lostReliabilitySec += lost * reliability / scale;
+    st.lostOtherSec += lost * (1.0 - std::min(active, dt) / dt);
+    return st;
+}
+
+} // namespace temper
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GpuBackend.hpp"
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace temper {
+
+// Per-cause throttle accounting since startup (seconds)
+struct ThrottleStats {
+    bool exact = false;              // From driver violation counters, else sampled reason bitmask
+    double powerSec = 0.0;
+    double thermalSec = 0.0;
+    double syncBoostSec = 0.0;
+    double reliabilitySec = 0.0;
+    double busySec = 0.0;            // Time with work on the GPU
+    double clockDeficitPercent = 0.0; // Current SM clock shortfall vs. max while busy
+    // Busy time x clock deficit, i.e. full-clock seconds of work lost, split by cause
+    double lostPowerSec = 0.0;
+    double lostThermalSec = 0.0;
+    double lostSyncBoostSec = 0.0;
+    double lostReliabilitySec = 0.0;
+    double lostOtherSec = 0.0;       // Deficit with no limiter active (e.g. light load)
+    double lostTotalSec = 0.0;
+};
+
+// Turns throttle snapshots into counters that can be rated/diffed downstream.
+//
+// The driver's violation counters cover the whole interval between ticks, so
+// short bursts are not missed; boards without them fall back to treating the
+// reason bitmask seen at the tick as active for the whole interval. The clock
+// deficit lost in an interval is attributed to the causes in proportion to
+// how long each was active.
+class ThrottleMeter {
+public:
+    ThrottleStats update(unsigned int device, const GpuBackend::ViolationTimes& violations,
+                         unsigned long long reasons, unsigned int smClock, unsigned int maxSmClock, bool busy);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct State {
+        bool started = false;
+        GpuBackend::ViolationTimes last;
+        Clock::time_point lastUpdate;
+        ThrottleStats stats;
+    };
+
+    std::mutex mutex_; // Guards the map only; each entry belongs to one device's poller
+    std::map<unsigned int, State> states_;
+};
+
+} // namespace temper
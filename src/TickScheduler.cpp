@@ -0,0 +1,96 @@
+#include "TickScheduler.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+#include <vector>
+
+namespace temper {
+
+static double toMs(TickScheduler::Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+static void push(std::deque<double>& window, double value, size_t size) {
+    window.push_back(value);
+    if (window.size() > size) window.pop_front();
+}
+
+TickScheduler::TickScheduler(Clock::duration period) : period_(period) {}
+
+unsigned long long TickScheduler::wait() {
+    auto now = Clock::now();
+    if (!started_) {
+        started_ = true;
+        next_ = now;
+    } else {
+        double workMs = toMs(now - wake_);
+        next_ += period_;
+        tick_++;
+        unsigned long long missed = 0;
+        if (now >= next_) {
+            // Overrun: drop the deadlines already passed instead of running them late
+            missed = (now - next_) / period_ + 1;
+            next_ += missed * period_;
+            tick_ += missed;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        push(workMs_, workMs, WINDOW);
+        if (missed) {
+            overruns_++;
+            skipped_ += missed;
+        }
+    }
+
+    // steady_clock is CLOCK_MONOTONIC
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next_.time_since_epoch()).count();
+    timespec ts{(time_t)(ns / 1000000000), (long)(ns % 1000000000)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+
+    auto woke = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    push(wakeMs_, toMs(woke - next_), WINDOW);
+    if (ticks_ > 0) push(jitterMs_, toMs(woke - wake_) - toMs(period_), WINDOW);
+    wake_ = woke;
+    ticks_++;
+    return tick_;
+}
+
+unsigned long long TickScheduler::ticksPer(Clock::duration interval) const {
+    return std::max<unsigned long long>(1, interval / period_);
+}
+
+LoopStats TickScheduler::getStats() const {
+    LoopStats s;
+    s.periodMs = toMs(period_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.ticks = ticks_;
+    s.overruns = overruns_;
+    s.skipped = skipped_;
+    if (!wakeMs_.empty()) {
+        std::vector<double> sorted(wakeMs_.begin(), wakeMs_.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (double v : sorted) s.wakeAvgMs += v;
+        s.wakeAvgMs /= sorted.size();
+        s.wakeP99Ms = sorted[(sorted.size() - 1) * 99 / 100];
+        s.wakeMaxMs = sorted.back();
+    }
+    if (!jitterMs_.empty()) {
+        double sumSq = 0.0;
+        for (double v : jitterMs_) {
+            sumSq += v * v;
+            s.jitterMaxMs = std::max(s.jitterMaxMs, std::fabs(v));
+        }
+        s.jitterRmsMs = std::sqrt(sumSq / jitterMs_.size());
+    }
+    if (!workMs_.empty()) {
+        for (double v : workMs_) {
+            s.workAvgMs += v;
+            s.workMaxMs = std::max(s.workMaxMs, v);
+        }
+        s.workAvgMs /= workMs_.size();
+    }
+    return s;
+}
+
+} // namespace temper
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace temper {
+
+// Control loop timing. Latencies are over the last minute of ticks, counters since startup.
+struct LoopStats {
+    double periodMs = 0.0;
+    unsigned long long tick = 0;      // Deadline index of the published readings (counts skipped ones)
+    double tickTime = 0.0;            // Unix seconds of that deadline
+    unsigned long long ticks = 0;     // Ticks run
+    unsigned long long overruns = 0;  // Ticks whose work ran past the next deadline
+    unsigned long long skipped = 0;   // Deadlines dropped because of overruns
+    double wakeAvgMs = 0.0;           // Wake-up lateness after the deadline
+    double wakeP99Ms = 0.0;
+    double wakeMaxMs = 0.0;
+    double jitterRmsMs = 0.0;         // RMS of tick-to-tick interval minus the period
+    double jitterMaxMs = 0.0;         // Largest |interval - period|
+    double workAvgMs = 0.0;           // From wake-up to the next wait
+    double workMaxMs = 0.0;
+};
+
+// Runs a loop on absolute deadlines (CLOCK_MONOTONIC, TIMER_ABSTIME), so the
+// period does not stretch by the work done in each tick. A tick that runs
+// past the next deadline is an overrun: the deadlines it missed are skipped
+// and counted rather than run back to back.
+//
+// wait() is called only from the loop thread; getStats() from anywhere.
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TickScheduler(Clock::duration period);
+
+    // Sleeps until the next deadline and returns its index (0 on the first call, immediately)
+    unsigned long long wait();
+    Clock::time_point deadline() const { return next_; }
+    unsigned long long ticksPer(Clock::duration interval) const;
+
+    LoopStats getStats() const;
+
+private:
+    static const size_t WINDOW = 600; // One minute at 10 Hz
+
+    Clock::duration period_;
+    Clock::time_point next_;
+    Clock::time_point wake_;
+    unsigned long long tick_ = 0;
+    bool started_ = false;
+
+    mutable std::mutex mutex_; // Guards the stats below
+    unsigned long long ticks_ = 0;
+    unsigned long long overruns_ = 0;
+    unsigned long long skipped_ = 0;
+    std::deque<double> wakeMs_;
+    std::deque<double> jitterMs_;
+    std::deque<double> workMs_;
+};
+
+} // namespace temper
@@ -1,49 +1,157 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <csignal>
+#include <cstdlib>
 #include <unistd.h>
 #include <iomanip>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <cmath>
+#include <sstream>
 
 #include "MetricServer.hpp"
 #include "NVMLManager.hpp"
+#include "SimulatedBackend.hpp"
+#include "Actuator.hpp"
+#include "EnergyMeter.hpp"
+#include "FanMonitor.hpp"
+#include "PowerBudget.hpp"
+#include "ThrottleMeter.hpp"
+#include "PcieMonitor.hpp"
+#include "DeviceWorker.hpp"
+#include "ActuationFilter.hpp"
+#include "ThermalModel.hpp"
 #include "CurveController.hpp"
+#include "ControlConfig.hpp"
+#include "CurveTuner.hpp"
+#include "TelemetryRecorder.hpp"
+#include "TelemetryCollector.hpp"
+#include "TickScheduler.hpp"
+#include "ProcessUtils.hpp"
+#include "RealtimeMode.hpp"
 #include "IpmiController.hpp"
 #include "HostMonitor.hpp"
 #include "LlamaMonitor.hpp"
 
 using namespace temper;
 
-// Global state for signal handling
+// Set by SIGINT/SIGTERM; the loop restores driver control on its way out
 static volatile std::sig_atomic_t g_running = 1;
-static std::vector<nvmlDevice_t> g_devices;
-static NVMLManager* g_nvmlPtr = nullptr;
-static MetricServer* g_serverPtr = nullptr;
 
-void signalHandler(int signum) {
+void signalHandler(int) {
     g_running = 0;
-    if (g_serverPtr) g_serverPtr->stop();
-    if (g_nvmlPtr) {
-        for (auto dev : g_devices) {
-            g_nvmlPtr->restoreAutoFans(dev);
+}
+
+// "1410" applies to every GPU; "1410,1200,0" gives per-index values (0: leave unlocked)
+static std::vector<unsigned int> parseClockList(const char* env) {
+    std::vector<unsigned int> values;
+    if (!env) return values;
+    std::string list(env);
+    for (auto& c : list) {
+        if (c == ',') c = ' ';
+    }
+    std::stringstream ss(list);
+    unsigned int mhz;
+    while (ss >> mhz) values.push_back(mhz);
+    return values;
+}
+
+static unsigned int clockFor(const std::vector<unsigned int>& values, unsigned int index) {
+    if (values.empty()) return 0;
+    if (values.size() == 1) return values[0];
+    return index < values.size() ? values[index] : 0;
+}
+
+// temper tune <recording.csv> target:<C> [pct:<percentile>] [min:<fan%>]
+static int runTune(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: temper tune <recording.csv> target:<C> [pct:<percentile>] [min:<fan%>]" << std::endl;
+        return 1;
+    }
+    TuneOptions options;
+    for (int i = 3; i < argc; ++i) {
+        std::string token = argv[i];
+        auto colon = token.find(':');
+        std::string key = token.substr(0, colon);
+        double value = colon == std::string::npos ? 0.0 : std::atof(token.c_str() + colon + 1);
+        if (key == "target") options.targetC = value;
+        else if (key == "pct") options.percentile = value;
+        else if (key == "min") options.minFan = (unsigned int)std::max(0.0, value);
+        else std::cerr << "[Tune] Ignoring unknown option: " << token << std::endl;
+    }
+    if (options.targetC <= 0.0) {
+        std::cerr << "[Tune] A target temperature is required (target:<C>)" << std::endl;
+        return 1;
+    }
+
+    CurveTuner tuner(options);
+    if (!tuner.load(argv[2])) return 1;
+    auto started = std::chrono::steady_clock::now();
+    auto results = tuner.run();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::string rules;
+    bool allFound = true;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        std::cout << "[Tune] GPU " << r.gpu << " (" << (r.uuid.empty() ? "no uuid" : r.uuid) << "): " << r.samples
+                  << " samples, recorded fan " << r.recordedFanAvg << "%, p" << options.percentile << " "
+                  << r.recordedPercentileC << "C";
+        if (r.throttleLimitC > 0.0) std::cout << ", throttles at " << r.throttleLimitC << "C";
+        std::cout << std::endl;
+        if (!r.fitted) {
+            std::cout << "[Tune] GPU " << r.gpu << ": not enough fan and power variation to model it" << std::endl;
+            allFound = false;
+            continue;
+        }
+        std::cout << "[Tune] GPU " << r.gpu << ": model replay error " << r.fitRmseC << "C RMS, time constant "
+                  << r.timeConstantSec << "s" << std::endl;
+        if (!r.found) {
+            std::cout << "[Tune] GPU " << r.gpu << ": no curve keeps p" << options.percentile << " at or below "
+                      << options.targetC << "C without throttling" << std::endl;
+            allFound = false;
+            continue;
         }
+        std::cout << "[Tune] GPU " << r.gpu << ": \"" << r.setpoints << "\" -> fan " << r.fanAvg << "%, p"
+                  << options.percentile << " " << r.percentileC << "C, max " << r.maxC << "C" << std::endl;
+        if (!rules.empty()) rules += "; ";
+        rules += (r.uuid.empty() ? std::to_string(r.gpu) : r.uuid) + "=" + r.setpoints;
     }
-    if (signum == SIGSEGV || signum == SIGBUS) _exit(128 + signum);
+    std::cout << "[Tune] Searched in " << std::setprecision(2) << elapsed << "s" << std::endl;
+    if (!rules.empty()) std::cout << "GPU_FAN_CURVES=\"" << rules << "\"" << std::endl;
+    return allFound ? 0 : 2;
 }
 
 int main(int argc, char* argv[]) {
+    // Offline: needs neither a GPU nor the metric server
+    if (argc >= 2 && std::string(argv[1]) == "tune") return runTune(argc, argv);
+
     try {
-        NVMLManager nvml;
-        g_nvmlPtr = &nvml;
+        // SIM_GPUS=<n> swaps NVML for the thermal model (no driver required)
+        std::unique_ptr<GpuBackend> backend;
+        const char* simEnv = std::getenv("SIM_GPUS");
+        if (simEnv) {
+            char* end = nullptr;
+            unsigned long count = std::strtoul(simEnv, &end, 10);
+            if (end == simEnv || *end != '\0' || simEnv[0] == '-' || count == 0 || count > MAX_DEVICES) {
+                std::cerr << "Usage: SIM_GPUS=<1-" << MAX_DEVICES << "> temper <command> [args...] (got \"" << simEnv << "\")" << std::endl;
+                return 1;
+            }
+            backend = std::make_unique<SimulatedBackend>(count);
+            std::cout << "Using simulated GPU backend" << std::endl;
+        } else {
+            backend = std::make_unique<NVMLManager>();
+        }
+        GpuBackend& nvml = *backend;
 
-        CurveController fanCurve;
-        CurveController powerCurve;
-        CurveController chassisCurve;
+        CurveController clockCurve;
         
         // Start Metric Server
         MetricServer server(3001);
-        g_serverPtr = &server;
         server.start();
 
         if (argc < 2) {
@@ -58,21 +166,98 @@ int main(int argc, char* argv[]) {
                 fanArgs += argv[i];
                 fanArgs += " ";
             }
-            fanCurve.parseSetpoints(fanArgs);
             
-            const char* pEnv = std::getenv("POWER_SETPOINTS");
-            if (pEnv) powerCurve.parseSetpoints(pEnv);
-
-            const char* cEnv = std::getenv("CHASSIS_FAN_SETPOINTS");
-            if (cEnv) {
-                chassisCurve.parseSetpoints(cEnv);
-            } else {
-                chassisCurve.parseSetpoints(fanArgs); // Default to GPU curve
+            // Startup curves; CONFIG_FILE and POST /config can replace them while running
+            auto envString = [](const char* name) {
+                const char* value = std::getenv(name);
+                return std::string(value ? value : "");
+            };
+            CurveSettings curveSettings;
+            curveSettings.fan = fanArgs;
+            curveSettings.power = envString("POWER_SETPOINTS");
+            curveSettings.chassis = envString("CHASSIS_FAN_SETPOINTS");
+            curveSettings.gpuFan = envString("GPU_FAN_CURVES");
+            curveSettings.gpuPower = envString("GPU_POWER_CURVES");
+
+            // Locked-clock mode: a temperature curve, or fixed per-GPU targets
+            const char* clkEnv = std::getenv("CLOCK_SETPOINTS");
+            if (clkEnv) clockCurve.parseSetpoints(clkEnv);
+            if (clockCurve.isPid()) {
+                std::cerr << "PID mode only applies to fan curves; ignoring CLOCK_SETPOINTS" << std::endl;
+                clockCurve.parseSetpoints("");
             }
+            std::vector<unsigned int> gpuClockLocks = parseClockList(std::getenv("CLOCK_LOCK"));
+            std::vector<unsigned int> memClockLocks = parseClockList(std::getenv("MEM_CLOCK_LOCK"));
+            bool clockControl = !clockCurve.isEmpty() || !gpuClockLocks.empty() || !memClockLocks.empty();
+
+            // FAN_SENSOR=max drives the curves from max(core, memory - MEM_TEMP_OFFSET)
+            const char* sensorEnv = std::getenv("FAN_SENSOR");
+            bool useMemorySensor = sensorEnv && std::string(sensorEnv) == "max";
+            const char* offsetEnv = std::getenv("MEM_TEMP_OFFSET");
+            unsigned int memTempOffset = offsetEnv ? std::strtoul(offsetEnv, nullptr, 10) : 20;
+            // FAN_FEEDFORWARD=1 also feeds the curves the thermal model's forecast when it is hotter
+            bool fanFeedForward = std::getenv("FAN_FEEDFORWARD") != nullptr;
 
             unsigned int count = nvml.getDeviceCount();
+            Actuator actuator(nvml);
+            std::vector<nvmlDevice_t> devices;
+            std::vector<std::string> uuids;
+            std::vector<std::string> names, serials, vbiosVersions; // Static: read once, not every tick
+            std::vector<unsigned int> slowdownTemps; // 0: unknown
+            for (unsigned int i = 0; i < count; ++i) {
+                nvmlDevice_t handle = nvml.getHandle(i);
+                devices.push_back(handle);
+                uuids.push_back(nvml.getUUID(handle));
+                names.push_back(nvml.getName(handle));
+                serials.push_back(nvml.getSerial(handle));
+                vbiosVersions.push_back(nvml.getVbiosVersion(handle));
+                unsigned int slowdown = 0;
+                nvml.getSlowdownTemperature(handle, slowdown);
+                slowdownTemps.push_back(slowdown);
+                actuator.addDevice(handle);
+
+                unsigned int caps = nvml.getCapabilities(handle);
+                std::string missing;
+                if (!(caps & GpuBackend::CAP_TEMPERATURE)) missing += " temperature";
+                if (!(caps & GpuBackend::CAP_POWER_USAGE)) missing += " power";
+                if (!(caps & GpuBackend::CAP_POWER_LIMIT)) missing += " power-limit";
+                if (!(caps & GpuBackend::CAP_UTILIZATION)) missing += " utilization";
+                if (!(caps & GpuBackend::CAP_MEMORY)) missing += " memory";
+                if (!(caps & GpuBackend::CAP_THROTTLE)) missing += " throttle-reasons";
+                if (!(caps & GpuBackend::CAP_ECC)) missing += " ecc";
+                if (actuator.getNumFans(i) == 0) missing += " fans";
+                if (!missing.empty()) std::cout << "[" << i << "] Not supported, skipped:" << missing << std::endl;
+            }
+
+            // One controller per device, so the loop indexes instead of matching rules
+            ControlConfig controlConfig(curveSettings, uuids, names);
+            const char* configFile = std::getenv("CONFIG_FILE");
+            if (configFile) controlConfig.watch(configFile);
+            server.setConfigHandler([&controlConfig](const std::string& body, std::string& message) {
+                if (!controlConfig.apply(body, "http", message, true)) return false;
+                message = "generation " + std::to_string(controlConfig.getStatus().generation);
+                return true;
+            });
+            EnergyMeter energyMeter;
+            FanMonitor fanMonitor;
+            PowerBudget powerBudget;
+            ThrottleMeter throttleMeter;
+            ActuationFilter actuationFilter;
+            ThermalModel thermalModel;
+            PcieMonitor pcieMonitor;
+            TelemetryRecorder recorder;
+            if (powerBudget.isEnabled()) {
+                std::cout << "[PowerBudget] Distributing " << powerBudget.getMetrics().budgetW << "W across GPUs"
+                          << (controlConfig.current()->anyPower ? " (POWER_SETPOINTS ignored)" : "") << std::endl;
+            }
+
+            // Optional per-fan curves (FAN<n>_SETPOINTS) override the main curve for fan index n
+            std::map<unsigned int, CurveController> perFanCurves;
             for (unsigned int i = 0; i < count; ++i) {
-                g_devices.push_back(nvml.getHandle(i));
+                for (unsigned int f = 0; f < actuator.getNumFans(i); ++f) {
+                    const char* fEnv = std::getenv(("FAN" + std::to_string(f) + "_SETPOINTS").c_str());
+                    if (fEnv && !perFanCurves.count(f)) perFanCurves[f].parseSetpoints(fEnv);
+                }
             }
 
             std::signal(SIGINT, signalHandler);
@@ -101,143 +286,392 @@ int main(int argc, char* argv[]) {
             llamaMonitor.start();
 
             bool verbose = (std::getenv("VERBOSE") != nullptr);
-            int loopCounter = 0;
             unsigned int lastChassisFan = 0;
+            std::shared_ptr<CurveSet> chassisCurves; // Generation the chassis loop last ran on
+            std::vector<GpuMetrics> lastMetrics;
+
+            struct DevicePoll {
+                GpuMetrics metrics;
+                bool haveTemp = false;
+                std::string status; // Verbose line
+            };
+            std::vector<DevicePoll> polls(count);
+            std::vector<std::shared_ptr<CurveSet>> deviceCurves(count); // Generation each device last ran on
+
+            // The control path reads only what it acts on: temperature, throttle reasons and
+            // power draw (thermal model). Utilization and the enforced limit only feed the
+            // power budget. Fans, memory and the rest are read by the telemetry workers.
+            unsigned int controlReads = GpuBackend::CAP_TEMPERATURE | GpuBackend::CAP_THROTTLE | GpuBackend::CAP_POWER_USAGE;
+            if (powerBudget.isEnabled()) controlReads |= GpuBackend::CAP_UTILIZATION | GpuBackend::CAP_POWER_LIMIT;
+
+            // One tick of a device: read, actuate, store the control readings in polls[i].
+            // Runs on the device's worker, so it only touches that device's state.
+            auto pollDevice = [&](unsigned int i, const std::shared_ptr<CurveSet>& curveSet, bool budgeted, unsigned int budgetW, double inletC) {
+                CurveSet& curves = *curveSet;
+                CurveController& fanCurve = curves.fan[i];
+                CurveController& powerCurve = curves.power[i];
+                auto handle = devices[i];
+                auto core = nvml.readCore(handle, controlReads); // Never throws; absent readings have their bit clear
+                bool haveTemp = core.valid & GpuBackend::CAP_TEMPERATURE;
+                unsigned int coreTemp = core.temperature;
+                unsigned int memTemp = 0;
+                bool haveMemTemp = useMemorySensor && nvml.getMemoryTemperature(handle, memTemp);
+                unsigned int temp = coreTemp;
+                const char* sensor = "core";
+                if (useMemorySensor && haveMemTemp && memTemp > coreTemp + memTempOffset) {
+                    temp = memTemp - memTempOffset;
+                    sensor = "memory";
+                }
+                double curveInput = temp;
+                if (fanFeedForward && haveTemp) {
+                    // Act on where the temperature is heading at current power, ahead of the lag
+                    double forecast = thermalModel.predicted(i, temp);
+                    if (forecast > curveInput) {
+                        curveInput = forecast;
+                        sensor = "forecast";
+                    }
+                }
+                
+                // A reloaded curve picks up the PID loop where the previous generation left it
+                if (deviceCurves[i] != curveSet) {
+                    if (deviceCurves[i]) fanCurve.continueFrom(i, deviceCurves[i]->fan[i], polls[i].metrics.targetFan);
+                    deviceCurves[i] = curveSet;
+                }
 
-            while (g_running) {
-                loopCounter++;
-                try {
-                    // 1. Poll Host Metrics (Fast)
-                    hostMonitor.update();
-                    HostMetrics hostMetrics = hostMonitor.getMetrics();
+                // Without a temperature reading the curves have no input: leave the device alone
+                double curveTemp = haveTemp ? actuationFilter.smoothTemperature(i, curveInput) : temp;
+                unsigned int targetFan = haveTemp ? fanCurve.evaluate(i, curveTemp) : 0;
+                std::vector<unsigned int> fanTargets(haveTemp ? actuator.getNumFans(i) : 0, targetFan);
+                for (unsigned int f = 0; f < fanTargets.size(); ++f) {
+                    auto pf = perFanCurves.find(f);
+                    CurveController& curve = pf == perFanCurves.end() ? fanCurve : pf->second;
+                    if (&curve != &fanCurve) fanTargets[f] = curve.evaluate(i, curveTemp);
+                    // The unfiltered target is only counted; a PID loop has no stateless equivalent
+                    unsigned int raw = curve.isPid() ? fanTargets[f] : curve.interpolate(temp);
+                    fanTargets[f] = actuationFilter.filterFan(i, f, fanTargets[f], raw, curveTemp, curve.isPid());
+                    actuator.applyFanSpeed(i, f, fanTargets[f]);
+                }
+                if (!fanTargets.empty()) targetFan = fanTargets[0];
 
-                    // 2. Poll IPMI Metrics
-                    // OPTIMIZED: Normal mode checks every 20 loops (2s).
-                    if ((loopCounter == 1 || loopCounter % 20 == 0) && ipmi.isEnabled() && !ipmi.isPolling()) {
-                        ipmi.startAsyncPoll();
-                    }
-                    IpmiMetrics ipmiMetrics = ipmi.getMetrics();
-                    ipmiMetrics.targetFanSpeed = lastChassisFan;
+                std::string powerStr = "";
+                unsigned int currentPowerLimit = 0;
+                unsigned int currentPowerUsage = core.powerUsage; // mW
+                unsigned long long reasons = core.throttleReasons;
 
-                    // 3. Poll NVML Metrics
-                    unsigned int maxTemp = 0;
-                    std::vector<GpuMetrics> currentMetrics;
+                if ((budgeted || (haveTemp && !powerCurve.isEmpty())) && actuator.hasPowerControl(i)) {
+                    unsigned int targetPower = budgeted ? budgetW : powerCurve.interpolateFixed(CurveController::toFixed(curveTemp));
+                    
+                    // Constraints are probed once at startup
+                    unsigned int minW = 0, maxW = 0;
+                    actuator.getPowerConstraints(i, minW, maxW);
+
+                    std::string alert = "";
+                    bool thermalSlowdown = reasons & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwSlowdown);
+                    if (actuationFilter.confirmThrottle(i, thermalSlowdown)) {
+                        // Hardware is already panicking. React by cutting power to minimum.
+                        targetPower = minW; 
+                        actuationFilter.forcePower(i, minW);
+                        alert = "[REACTIVE FALLBACK: " + std::to_string(minW) + "W]";
+                    } else if (!budgeted) {
+                        // The budget allocator paces itself; only curve targets are smoothed
+                        targetPower = std::clamp(targetPower, minW, maxW);
+                        unsigned int rawW = std::clamp(powerCurve.interpolate(temp), minW, maxW);
+                        targetPower = actuationFilter.filterPower(i, targetPower, rawW, curveTemp);
+                    }
 
-                    for (unsigned int i = 0; i < g_devices.size(); ++i) {
-                        auto handle = g_devices[i];
-                        unsigned int temp = nvml.getTemperature(handle);
-                        if (temp > maxTemp) maxTemp = temp;
-                        
-                        unsigned int targetFan = fanCurve.interpolate(temp);
-                        nvml.setFanSpeed(handle, targetFan);
-
-                        std::string powerStr = "";
-                        unsigned int currentPowerLimit = 0;
-                        unsigned int currentPowerUsage = nvml.getPowerUsage(handle); // mW
-
-                        if (!powerCurve.isEmpty()) {
-                            unsigned int targetPower = powerCurve.interpolate(temp);
-                            
-                            unsigned int minW = 0, maxW = 0;
-                            try {
-                                nvml.getPowerConstraints(handle, minW, maxW);
-                            } catch (...) {
-                                // Default fallback if constraints check fails
-                                minW = 125; maxW = 300; 
-                            }
+                    // Clamped to hardware limits; unchanged targets are not rewritten
+                    targetPower = actuator.applyPowerLimit(i, targetPower);
+                    currentPowerLimit = targetPower ? targetPower * 1000 : core.powerLimit; // 0: telemetry fills in
 
-                            unsigned long long reasons = nvml.getThrottleReasons(handle);
-                            std::string alert = "";
-                            if (reasons & nvmlClocksThrottleReasonSwThermalSlowdown || reasons & nvmlClocksThrottleReasonHwSlowdown) {
-                                // Hardware is already panicking. React by cutting power to minimum.
-                                targetPower = minW; 
-                                alert = "[REACTIVE FALLBACK: " + std::to_string(minW) + "W]";
-                            }
+                    powerStr = "\tPower: " + std::to_string(targetPower) + "W" + (alert.empty() ? "" : " " + alert);
+                } else {
+                    currentPowerLimit = core.powerLimit;
+                }
 
-                            // Clamp target power to hardware limits
-                            if (targetPower < minW) targetPower = minW;
-                            if (targetPower > maxW) targetPower = maxW;
+                if (clockControl && actuator.hasClockControl(i) && (haveTemp || clockCurve.isEmpty())) {
+                    unsigned int gpuMHz = clockCurve.isEmpty() ? clockFor(gpuClockLocks, i) : clockCurve.interpolate(temp);
+                    actuator.applyClockLock(i, gpuMHz, clockFor(memClockLocks, i));
+                    if (gpuMHz) powerStr += "\tClock: " + std::to_string(gpuMHz) + "MHz";
+                }
+                
+                // Control-side readings; the slow groups are merged in by the telemetry thread
+                GpuMetrics m{};
+                m.index = i;
+                m.present = core.valid | (nvml.getCapabilities(handle) & GpuBackend::CAP_ECC);
+                m.name = names[i];
+                m.serial = serials[i];
+                m.vbios = vbiosVersions[i];
+
+                m.temp = coreTemp;
+                m.controlTemp = temp;
+                m.controlSensor = sensor;
+                m.curveTemp = curveTemp;
+                m.targetFan = targetFan;
+                m.fanPid = fanCurve.getPidStatus(i);
+                m.fanCurveRule = curves.fanRules[i];
+                m.fanTargets = fanTargets;
+                if (haveTemp && (core.valid & GpuBackend::CAP_POWER_USAGE)) {
+                    // The commanded speeds stand in for the fan readings, which are telemetry
+                    double fanAvg = 0.0;
+                    for (unsigned int f : fanTargets) fanAvg += f;
+                    if (!fanTargets.empty()) fanAvg /= fanTargets.size();
+                    m.thermal = thermalModel.update(i, coreTemp, currentPowerUsage / 1000.0, fanAvg, inletC, slowdownTemps[i]);
+                }
+                m.powerUsage = currentPowerUsage;
+                m.powerLimit = currentPowerLimit;
+                m.utilGpu = core.utilGpu; // Power budget only
+                if (useMemorySensor) {
+                    m.memTemp = memTemp;
+                    m.memTempSupported = haveMemTemp;
+                }
 
-                            nvml.setPowerLimit(handle, targetPower);
-                            currentPowerLimit = targetPower * 1000;
+                actuator.getClockLock(i, m.lockedClockGraphics, m.lockedClockMemory);
+
+                // Throttle Check
+                if (reasons & nvmlClocksThrottleReasonSwThermalSlowdown) m.throttleAlert = "SW Thermal Slowdown";
+                else if (reasons & nvmlClocksThrottleReasonHwSlowdown) m.throttleAlert = "HW Thermal Slowdown";
+                m.throttleReasonsBitmask = reasons;
+
+                ActuationStats act = actuator.getStats(i);
+                m.fanWrites = act.fanWrites;
+                m.fanWritesSuppressed = act.fanWritesSuppressed;
+                m.powerWrites = act.powerWrites;
+                m.powerWritesSuppressed = act.powerWritesSuppressed;
+                m.clockWrites = act.clockWrites;
+                m.clockWritesSuppressed = act.clockWritesSuppressed;
+                m.actuationErrors = act.writeErrors;
+                m.smoothing = actuationFilter.getStats(i);
+                
+                DevicePoll& poll = polls[i];
+                poll.haveTemp = haveTemp;
+                poll.metrics = std::move(m);
+                poll.status = "[" + std::to_string(i) + "] Temp: " + std::to_string(temp) + "C \tFan: " + std::to_string(targetFan) + "%" + powerStr;
+            };
+
+            // A device that misses NVML_DEADLINE_MS is skipped, and its last good
+            // metrics republished as stale, until its worker returns
+            const char* deadlineEnv = std::getenv("NVML_DEADLINE_MS");
+            std::chrono::milliseconds nvmlDeadline(deadlineEnv ? std::strtoul(deadlineEnv, nullptr, 10) : 500);
+            if (!ipmi.isEnabled()) {
+                // The chassis fans are the only fallback for a GPU whose fans can't be commanded
+                std::cerr << "[Watchdog] No IPMI: a GPU that misses the " << nvmlDeadline.count()
+                          << "ms NVML deadline will be left on its last fan command" << std::endl;
+            }
+            struct DeviceHealth {
+                bool responsive = true;
+                std::chrono::steady_clock::time_point lastGood = std::chrono::steady_clock::now();
+                unsigned long long hangEvents = 0;
+            };
+            std::vector<DeviceHealth> health(count);
+
+            // The control loop publishes its readings here each tick; the telemetry
+            // thread adds the slow groups and serves them, so neither waits on the other
+            struct ControlSnapshot {
+                std::vector<GpuMetrics> gpus;
+                IpmiMetrics ipmi;
+                PowerBudgetMetrics budget;
+                unsigned long long tick = 0;
+                TickScheduler::Clock::time_point deadline;
+            };
+            std::mutex snapshotMutex;
+            ControlSnapshot snapshot;
+
+            // Ticks run on absolute deadlines; the 2s IPMI and chassis jobs sit on the same grid, a second apart
+            const char* periodEnv = std::getenv("CONTROL_PERIOD_MS");
+            unsigned long periodMs = periodEnv ? std::max(1ul, std::strtoul(periodEnv, nullptr, 10)) : 100;
+            TickScheduler ticker(std::chrono::milliseconds{periodMs});
+            const unsigned long long slowEvery = ticker.ticksPer(std::chrono::seconds(2));
+            unsigned long long nextIpmiTick = 0;
+            unsigned long long nextChassisTick = slowEvery / 2;
+            // A job whose tick was skipped by an overrun runs on the next one instead of being dropped
+            auto slotDue = [slowEvery](unsigned long long tick, unsigned long long& next) {
+                if (tick < next) return false;
+                while (next <= tick) next += slowEvery;
+                return true;
+            };
+            TelemetryCollector collector(nvml, energyMeter, throttleMeter, pcieMonitor, fanMonitor, devices, uuids);
+            const char* publishEnv = std::getenv("METRICS_PUBLISH_MS");
+            std::chrono::milliseconds publishInterval(publishEnv ? std::strtoul(publishEnv, nullptr, 10) : 100);
+
+            RealtimeMode realtime;
+
+            std::vector<std::unique_ptr<DeviceWorker>> workers; // Last, so they go before what jobs reference
+            std::vector<std::unique_ptr<DeviceWorker>> telemetryWorkers;
+            for (unsigned int i = 0; i < count; ++i) {
+                workers.push_back(std::make_unique<DeviceWorker>());
+                telemetryWorkers.push_back(std::make_unique<DeviceWorker>());
+            }
 
-                            powerStr = "\tPower: " + std::to_string(targetPower) + "W" + (alert.empty() ? "" : " " + alert);
-                        } else {
-                            currentPowerLimit = nvml.getPowerLimit(handle);
+            std::thread telemetryThread([&] {
+                blockShutdownSignals();
+
+                auto next = std::chrono::steady_clock::now();
+                while (g_running) {
+                    next += publishInterval;
+                    try {
+                        ControlSnapshot published;
+                        {
+                            std::lock_guard<std::mutex> lock(snapshotMutex);
+                            published = snapshot;
                         }
-                        
-                        // Collect Full Telemetry
-                        GpuMetrics m;
-                        m.index = i;
-                        m.name = nvml.getName(handle);
-                        m.serial = nvml.getSerial(handle);
-                        m.vbios = nvml.getVbiosVersion(handle);
-                        m.pState = nvml.getPowerState(handle);
-                        switch(m.pState) {
-                            case 0: m.pStateDescription = "Maximum Performance"; break;
-                            case 1: m.pStateDescription = "Performance"; break;
-                            case 2: m.pStateDescription = "Balanced"; break;
-                            case 5: m.pStateDescription = "Compute/Video"; break;
-                            case 8: m.pStateDescription = "Idle/Low Power"; break;
-                            case 15: m.pStateDescription = "Minimum Power"; break;
-                            default: m.pStateDescription = "Unknown"; break;
+                        if (!published.gpus.empty()) {
+                            // A slow collection only delays that device's next one; hung devices are left alone
+                            for (const auto& m : published.gpus) {
+                                unsigned int i = m.index;
+                                if (!m.responsive || telemetryWorkers[i]->busy() || !collector.due(i)) continue;
+                                telemetryWorkers[i]->submit([&collector, i, control = m] { collector.collect(i, control); });
+                            }
+
+                            hostMonitor.update();
+                            for (auto& m : published.gpus) collector.merge(m);
+                            LoopStats loop = ticker.getStats();
+                            loop.tick = published.tick;
+                            auto sinceDeadline = std::chrono::steady_clock::now() - published.deadline;
+                            loop.tickTime = std::chrono::duration<double>((std::chrono::system_clock::now() - sinceDeadline).time_since_epoch()).count();
+                            server.updateMetrics(published.gpus, hostMonitor.getMetrics(), published.ipmi, llamaMonitor.getMetrics(),
+                                                 published.budget, controlConfig.getStatus(), loop, realtime.getStatus());
+                            energyMeter.checkpoint();
+                            recorder.record(published.gpus, uuids, slowdownTemps);
                         }
+                    } catch (const std::exception& e) {
+                        std::cerr << "Telemetry Error: " << e.what() << std::endl;
+                    }
+                    auto now = std::chrono::steady_clock::now();
+                    if (next < now) next = now; // Fell behind: start the grid again rather than catch up
+                    std::this_thread::sleep_until(next);
+                }
+            });
+
+            // Real-time scheduling for the loop and its control workers, once every other thread has started
+            if (realtime.isRequested()) {
+                realtime.lockMemory();
+                realtime.enterLoopThread();
+                for (auto& worker : workers) {
+                    if (worker->submit([&realtime] { realtime.enterWorkerThread(); })) {
+                        worker->waitUntil(std::chrono::steady_clock::now() + nvmlDeadline);
+                    }
+                }
+            }
+            realtime.selfCheck();
 
-                        m.temp = temp;
-                        m.targetFan = targetFan;
-                        m.fanSpeed = nvml.getFanSpeed(handle);
-                        m.powerUsage = currentPowerUsage;
-                        m.powerLimit = currentPowerLimit;
-                        
-                        nvml.getUtilization(handle, m.utilGpu, m.utilMem);
-                        nvml.getMemoryInfo(handle, m.memTotal, m.memUsed);
-                        
-                        // Advanced Metrics
-                        auto clocks = nvml.getClocks(handle);
-                        m.clockGraphics = clocks.graphics;
-                        m.clockMemory = clocks.memory;
-                        m.clockSm = clocks.sm;
-                        m.clockVideo = clocks.video;
-                        m.maxClockGraphics = clocks.maxGraphics;
-                        m.maxClockMemory = clocks.maxMemory;
-                        m.maxClockSm = clocks.maxSm;
-                        m.maxClockVideo = clocks.maxVideo;
-
-                        auto pcie = nvml.getPcieInfo(handle);
-                        m.pcieTx = pcie.txThroughput;
-                        m.pcieRx = pcie.rxThroughput;
-                        m.pcieGen = pcie.gen;
-                        m.pcieWidth = pcie.width;
-
-                        auto ecc = nvml.getEccCounts(handle);
-                        m.eccVolatileSingle = ecc.volatileSingle;
-                        m.eccVolatileDouble = ecc.volatileDouble;
-                        m.eccAggregateSingle = ecc.aggregateSingle;
-                        m.eccAggregateDouble = ecc.aggregateDouble;
-
-                        auto procs = nvml.getProcesses(handle);
-                        for (const auto& p : procs) {
-                            m.processes.push_back({p.pid, p.usedMemory, p.name});
+            while (g_running) {
+                unsigned long long tick = ticker.wait();
+                if (!g_running) break;
+                try {
+                    // 1. Poll IPMI Metrics every 2s
+                    if (ipmi.isEnabled() && slotDue(tick, nextIpmiTick) && !ipmi.isPolling()) {
+                        ipmi.startAsyncPoll();
+                    }
+                    IpmiMetrics ipmiMetrics = ipmi.getMetrics();
+                    ipmiMetrics.targetFanSpeed = lastChassisFan;
+
+                    // Node power budget, split using last tick's draw and utilization
+                    std::vector<unsigned int> budgetLimits;
+                    if (powerBudget.isEnabled() && lastMetrics.size() == devices.size()) {
+                        std::vector<PowerBudget::Demand> demands;
+                        for (unsigned int i = 0; i < lastMetrics.size(); ++i) {
+                            const GpuMetrics& lm = lastMetrics[i];
+                            PowerBudget::Demand d;
+                            d.drawW = lm.powerUsage / 1000.0;
+                            d.limitW = lm.powerLimit / 1000;
+                            d.util = lm.utilGpu;
+                            d.capped = lm.throttleReasonsBitmask & nvmlClocksThrottleReasonSwPowerCap;
+                            d.forceMin = lm.throttleReasonsBitmask & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwSlowdown);
+                            if (!lm.responsive) {
+                                d.minW = d.maxW = d.limitW; // Can't be steered; whatever limit it holds stays in force
+                            } else if (actuator.hasPowerControl(i)) {
+                                actuator.getPowerConstraints(i, d.minW, d.maxW);
+                            } else {
+                                d.minW = d.maxW = (unsigned int)std::ceil(d.drawW); // Fixed load we cannot steer
+                            }
+                            demands.push_back(d);
                         }
+                        budgetLimits = powerBudget.allocate(demands, ipmiMetrics);
+                    }
 
-                        // Throttle Check
-                        unsigned long long reasons = nvml.getThrottleReasons(handle);
-                        if (reasons & nvmlClocksThrottleReasonSwThermalSlowdown) m.throttleAlert = "SW Thermal Slowdown";
-                        else if (reasons & nvmlClocksThrottleReasonHwSlowdown) m.throttleAlert = "HW Thermal Slowdown";
-                        m.throttleReasonsBitmask = reasons;
-                        
-                        currentMetrics.push_back(m);
+                    // One curve generation for the whole tick; a job holds on to it even if it outlives the tick
+                    std::shared_ptr<CurveSet> curves = controlConfig.current();
+
+                    // 2. Poll NVML Metrics: every device on its own worker, waited on up to the deadline
+                    auto deadline = std::chrono::steady_clock::now() + nvmlDeadline;
+                    std::vector<bool> submitted(count);
+                    double inletC = ipmiMetrics.available ? ipmiMetrics.inletTemp : 0.0; // 0: unknown
+                    for (unsigned int i = 0; i < count; ++i) {
+                        bool budgeted = i < budgetLimits.size();
+                        unsigned int budgetW = budgeted ? budgetLimits[i] : 0;
+                        submitted[i] = workers[i]->submit([&pollDevice, curves, i, budgeted, budgetW, inletC] {
+                            pollDevice(i, curves, budgeted, budgetW, inletC);
+                        });
+                    }
 
-                        if (verbose) std::cout << "[" << i << "] Temp: " << temp << "C \tFan: " << targetFan << "%" << powerStr << std::endl;
+                    unsigned int maxTemp = 0;
+                    bool anyUnresponsive = false;
+                    std::vector<GpuMetrics> currentMetrics;
+                    for (unsigned int i = 0; i < count; ++i) {
+                        DeviceHealth& h = health[i];
+                        bool answered = submitted[i] && workers[i]->waitUntil(deadline);
+                        auto now = std::chrono::steady_clock::now();
+                        double stale = std::chrono::duration<double>(now - h.lastGood).count();
+                        GpuMetrics m;
+                        if (answered) {
+                            if (!h.responsive) {
+                                std::cout << "[Watchdog] GPU " << i << " responding again after " << stale << "s" << std::endl;
+                                actuator.invalidate(i); // Targets may have been lost while it was gone
+                            }
+                            h.responsive = true;
+                            h.lastGood = now;
+                            m = std::move(polls[i].metrics);
+                            if (polls[i].haveTemp && m.controlTemp > maxTemp) maxTemp = m.controlTemp;
+                            m.staleSeconds = 0.0;
+                            if (verbose) std::cout << polls[i].status << std::endl;
+                        } else {
+                            if (h.responsive) {
+                                h.hangEvents++;
+                                std::cerr << "[Watchdog] GPU " << i << " did not answer within " << nvmlDeadline.count()
+                                          << "ms; skipping it until it does" << std::endl;
+                            }
+                            h.responsive = false;
+                            anyUnresponsive = true;
+                            if (i < lastMetrics.size()) {
+                                m = lastMetrics[i];
+                            } else {
+                                // Hung before its first reading: identity only, every reading null
+                                m = GpuMetrics{};
+                                m.index = i;
+                                m.name = names[i];
+                                m.serial = serials[i];
+                                m.vbios = vbiosVersions[i];
+                                m.pStateDescription = "Unknown";
+                                m.controlSensor = "core";
+                            }
+                            m.staleSeconds = stale;
+                            if (verbose) std::cout << "[" << i << "] Unresponsive for " << (unsigned int)stale << "s" << std::endl;
+                        }
+                        m.responsive = h.responsive;
+                        m.hangEvents = h.hangEvents;
+                        currentMetrics.push_back(std::move(m));
                     }
                     
-                    // Push unified metrics to server
-                    server.updateMetrics(currentMetrics, hostMetrics, ipmiMetrics, llamaMonitor.getMetrics());
-                    
+                    // Hand the control readings to the telemetry thread
+                    {
+                        std::lock_guard<std::mutex> lock(snapshotMutex);
+                        snapshot.gpus = currentMetrics;
+                        snapshot.ipmi = ipmiMetrics;
+                        snapshot.budget = powerBudget.getMetrics();
+                        snapshot.tick = tick;
+                        snapshot.deadline = ticker.deadline();
+                    }
+
                     if (ipmi.isEnabled()) {
-                        // Increase responsiveness: Update chassis fan every 20 loops (~2 seconds)
-                        // Offset by 10 to avoid collision with IPMI polling (which happens at % 20 == 0)
-                        if (loopCounter % 20 == 10) {
+                        if (anyUnresponsive) {
+                            // A hung GPU's own fans can't be commanded: move air with the chassis fans instead
+                            if (lastChassisFan != 100) {
+                                std::cerr << "[Watchdog] Chassis fans to 100% while a GPU is unresponsive" << std::endl;
+                                lastChassisFan = 100;
+                                ipmi.setChassisFanSpeed(100);
+                            }
+                        // Chassis fan every 2s, offset by 1s from the IPMI poll
+                        } else if (slotDue(tick, nextChassisTick)) {
                             unsigned int cpuMaxTemp = 0;
                             for (unsigned int cpuT : ipmiMetrics.cpuTemps) {
                                 if (cpuT > cpuMaxTemp) cpuMaxTemp = cpuT;
@@ -245,7 +679,7 @@ int main(int argc, char* argv[]) {
 
                             bool gpuStruggling = false;
                             for (const auto& m : currentMetrics) {
-                                if (m.fanSpeed >= 95 || (m.throttleReasonsBitmask & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwSlowdown))) {
+                                if (m.targetFan >= 95 || (m.throttleReasonsBitmask & (nvmlClocksThrottleReasonSwThermalSlowdown | nvmlClocksThrottleReasonHwSlowdown))) {
                                     gpuStruggling = true;
                                     break;
                                 }
@@ -258,21 +692,49 @@ int main(int argc, char* argv[]) {
                                 source = "GPU (Help Mode)";
                             }
 
-                            unsigned int chassisFan = chassisCurve.interpolate(targetTemp);
+                            if (chassisCurves != curves) {
+                                if (chassisCurves) curves->chassis.continueFrom(CurveController::CHASSIS_SLOT, chassisCurves->chassis, lastChassisFan);
+                                chassisCurves = curves;
+                            }
+                            unsigned int chassisFan = curves->chassis.evaluate(CurveController::CHASSIS_SLOT, targetTemp);
                             lastChassisFan = chassisFan;
                             ipmi.setChassisFanSpeed(chassisFan);
                             if (verbose) std::cout << "[Chassis] " << source << " Max Temp: " << targetTemp << "C \tFan: " << chassisFan << "%" << std::endl;
                         }
                     }
 
+                    lastMetrics = std::move(currentMetrics);
+
                     if (verbose && isatty(STDOUT_FILENO)) {
-                        std::cout << "\033[" << (g_devices.size() + (ipmi.isEnabled() ? 1 : 0)) << "A" << std::flush;
+                        std::cout << "\033[" << (devices.size() + (ipmi.isEnabled() ? 1 : 0)) << "A" << std::flush;
                     }
                 } catch (const std::exception& e) {
                     std::cerr << "Loop Error: " << e.what() << std::endl;
                     // Attempt to keep server alive even if loop fails
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            telemetryThread.join();
+            server.stop();
+            // Hand fans and clocks back to the driver, skipping GPUs with a call still blocked
+            bool stuck = false;
+            for (unsigned int i = 0; i < count; ++i) {
+                if (telemetryWorkers[i]->busy()) stuck = true;
+                if (workers[i]->busy()) {
+                    stuck = true;
+                    continue;
+                }
+                try {
+                    nvml.restoreAutoFans(devices[i]);
+                    if (clockControl) actuator.resetClocks(i);
+                } catch (const std::exception& e) {
+                    std::cerr << "[Shutdown] GPU " << i << ": " << e.what() << std::endl;
+                }
+            }
+            energyMeter.checkpoint(true);
+            if (stuck) {
+                // A blocked job still references the loop's state; don't tear it down underneath it
+                std::cerr << "[Watchdog] Exiting with a GPU call still blocked" << std::endl;
+                std::_Exit(0);
             }
         } else {
              std::cout << "Command '" << command << "' not fully implemented in C++ yet (Try fanctl)." << std::endl;
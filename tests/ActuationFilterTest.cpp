@@ -0,0 +1,127 @@
+// ActuationFilter stages: hysteresis against temperature jitter, slew limits
+// (on measured tick time, so these run in real time) and throttle confirmation.
+
+#include "Check.hpp"
+#include "ActuationFilter.hpp"
+#include "CurveController.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+using namespace temper;
+using Clock = std::chrono::steady_clock;
+
+// The filter reads its settings from the environment when constructed
+static void configure(const char* smoothing, const char* rise, const char* fall, const char* fanSlew,
+                      const char* powerSlew, const char* throttleConfirm) {
+    setenv("TEMP_SMOOTHING_SEC", smoothing, 1);
+    setenv("HYSTERESIS_RISE_C", rise, 1);
+    setenv("HYSTERESIS_FALL_C", fall, 1);
+    setenv("FAN_SLEW_PCT_PER_SEC", fanSlew, 1);
+    setenv("POWER_SLEW_W_PER_SEC", powerSlew, 1);
+    setenv("THROTTLE_CONFIRM_SEC", throttleConfirm, 1);
+}
+
+static void sleepMs(int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+// ±1C around a setpoint flips the curve target every tick; the filtered target holds
+static void testJitter() {
+    configure("0", "2", "2", "0", "0", "0");
+    ActuationFilter filter;
+    CurveController curve;
+    curve.parseSetpoints("50:30 70:60 80:90");
+
+    const unsigned int temps[] = {60, 61, 59, 61, 60, 59, 61, 59, 60, 61};
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < sizeof(temps) / sizeof(temps[0]); ++i) {
+        unsigned int target = curve.interpolate(temps[i]);
+        unsigned int out = filter.filterFan(0, 0, target, target, temps[i], false);
+        if (i == 0) first = out;
+        CHECK(out == first);
+    }
+    SmoothingStats stats = filter.getStats(0);
+    CHECK(stats.fanChanges == 0);
+    CHECK(stats.fanChangesRaw > 0);
+
+    // A real move past the band is taken
+    unsigned int target = curve.interpolate(63);
+    CHECK(filter.filterFan(0, 0, target, target, 63, false) == target);
+    CHECK(filter.getStats(0).fanChanges == 1);
+
+    // Closed-loop targets skip hysteresis: the PID output moves on its own
+    CHECK(filter.filterFan(1, 0, 40, 40, 60, true) == 40);
+    CHECK(filter.filterFan(1, 0, 41, 41, 60.5, true) == 41);
+}
+
+// A step in the fan target is spread out at no more than the slew rate per measured second
+static void testFanSlew() {
+    const double slew = 100.0; // %/s
+    configure("0", "0", "0", "100", "0", "0");
+    ActuationFilter filter;
+
+    unsigned int last = filter.filterFan(0, 0, 30, 30, 50, false);
+    CHECK(last == 30);
+    Clock::time_point before = Clock::now();
+    bool reached = false;
+    for (int tick = 0; tick < 100 && !reached; ++tick) {
+        sleepMs(20);
+        unsigned int out = filter.filterFan(0, 0, 90, 90, 80, false);
+        Clock::time_point after = Clock::now();
+        // The filter's interval lies within [previous call start, this call end]; +1 for rounding
+        double bound = slew * std::chrono::duration<double>(after - before).count() + 1.0;
+        CHECK(out >= last && out - last <= bound);
+        reached = out == 90;
+        last = out;
+        before = after;
+    }
+    CHECK(reached);
+
+    // The whole step can't have been taken in the first tick
+    ActuationFilter fresh;
+    fresh.filterFan(0, 0, 30, 30, 50, false);
+    sleepMs(20);
+    CHECK(fresh.filterFan(0, 0, 90, 90, 80, false) < 90);
+}
+
+// A single throttle sample doesn't reach the minimum-power fallback; a sustained one does
+static void testThrottleConfirm() {
+    configure("0", "0", "0", "0", "50", "0.2");
+    ActuationFilter filter;
+    const unsigned int minW = 100, curveW = 300;
+
+    // One tick of the loop's power path (see main.cpp)
+    auto tick = [&](bool throttling) {
+        if (filter.confirmThrottle(0, throttling)) {
+            filter.forcePower(0, minW);
+            return minW;
+        }
+        return filter.filterPower(0, curveW, curveW, 70);
+    };
+
+    CHECK(tick(false) == curveW);
+    CHECK(tick(true) == curveW);  // The blip
+    CHECK(tick(false) == curveW);
+    CHECK(filter.getStats(0).throttleBlipsIgnored == 1);
+
+    CHECK(tick(true) == curveW);
+    sleepMs(250);
+    CHECK(tick(true) == minW);    // Confirmed: straight to the minimum
+    CHECK(tick(true) == minW);
+
+    // Cleared: back up from the minimum at the power slew rate, not in one jump
+    sleepMs(20);
+    unsigned int w = tick(false);
+    CHECK(w > minW && w < curveW);
+
+    // Without a confirmation time the first sample acts, as before the filter existed
+    configure("0", "0", "0", "0", "0", "0");
+    ActuationFilter immediate;
+    CHECK(immediate.confirmThrottle(0, true));
+}
+
+int main() {
+    testJitter();
+    testFanSlew();
+    testThrottleConfirm();
+    return test::finish("ActuationFilterTest");
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Minimal assertions for the `make check` programs: a failed CHECK is
+// reported with its location and the program exits non-zero at the end.
+
+#include <iostream>
+
+namespace temper {
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int finish(const char* name) {
+    if (failures()) {
+        std::cerr << "[" << name << "] " << failures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[" << name << "] OK" << std::endl;
+    return 0;
+}
+
+} // namespace test
+} // namespace temper
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+            temper::test::failures()++;                                              \
+        }                                                                            \
+    } while (0)
@@ -0,0 +1,46 @@
+// Curve lookup cost: the compiled table against the floating point segment
+// search it replaced. Run with `make bench`.
+
+#include "CurveReference.hpp"
+#include "CurveController.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace temper;
+
+template <typename F>
+static double nsPerLookup(const std::vector<unsigned int>& temps, F lookup, unsigned long long& sink) {
+    const int rounds = 50;
+    for (unsigned int t : temps) sink += lookup(t); // Warm-up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (unsigned int t : temps) sink += lookup(t);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (rounds * temps.size());
+}
+
+int main() {
+    const char* curves[] = {"50:30 70:60 80:90", "30:20 40:25 50:30 60:45 65:55 70:65 75:80 80:90 85:100"};
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<unsigned int> dist(20 << CurveController::FRACTION_BITS, 95 << CurveController::FRACTION_BITS);
+    std::vector<unsigned int> temps(1 << 16);
+    for (auto& t : temps) t = dist(rng);
+
+    unsigned long long sink = 0;
+    for (const char* setpoints : curves) {
+        CurveController curve;
+        curve.parseSetpoints(setpoints);
+        const auto& points = curve.getPoints();
+        double reference = nsPerLookup(temps, [&](unsigned int t) {
+            return test::referenceInterpolate(points, (double)t / (1u << CurveController::FRACTION_BITS));
+        }, sink);
+        double table = nsPerLookup(temps, [&](unsigned int t) { return curve.interpolateFixed(t); }, sink);
+        std::cout << "[CurveBench] " << points.size() << " setpoints: segment search " << reference
+                  << " ns/lookup, table " << table << " ns/lookup" << std::endl;
+    }
+    return sink == 0; // Keeps the lookups from being optimized away
+}
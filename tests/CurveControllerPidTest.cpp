@@ -0,0 +1,123 @@
+// Closed-loop (pid:) mode of CurveController. Loops run with period:0, so
+// every evaluate() is a step and dt is the real time between calls: back to
+// back the integral barely moves, while the anti-windup checks sleep between
+// steps and use a large ki so it saturates.
+
+#include "Check.hpp"
+#include "CurveController.hpp"
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
+using namespace temper;
+
+static CurveController make(const std::string& setpoints) {
+    CurveController c;
+    c.parseSetpoints(setpoints);
+    return c;
+}
+
+static bool near(double a, double b) { return std::fabs(a - b) < 0.5; }
+
+static void pause() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+
+// Saturated in either direction, the integral stays within [min, max] and the
+// output recovers on the first step back (anti-windup)
+static void testAntiWindup() {
+    // ki is large enough that each ~2ms step would integrate far past the limits
+    CurveController c = make("pid:60 kp:0.5 ki:2000 min:20 max:80 period:0");
+    for (int step = 0; step < 50; ++step) {
+        unsigned int out = c.evaluate(0, 95);
+        auto s = c.getPidStatus(0);
+        CHECK(out <= 80 && out >= 20);
+        CHECK(s.integral >= 20.0 && s.integral <= 80.0);
+        pause();
+    }
+    CHECK(c.evaluate(0, 95) == 80);
+
+    // One step below target: the integral never wound up, so the output leaves the ceiling at once
+    pause();
+    CHECK(c.evaluate(0, 50) < 80);
+
+    for (int step = 0; step < 50; ++step) {
+        c.evaluate(0, 20);
+        auto s = c.getPidStatus(0);
+        CHECK(s.integral >= 20.0 && s.integral <= 80.0);
+        pause();
+    }
+    CHECK(c.evaluate(0, 20) == 20);
+    pause();
+    CHECK(c.evaluate(0, 70) > 20);
+}
+
+// The output is clamped to min/max whatever the error, and min/max given in
+// the wrong order are swapped
+static void testOutputClamp() {
+    CurveController c = make("pid:70 kp:50 ki:0 min:25 max:85 period:0");
+    CHECK(c.evaluate(0, 200) == 85);
+    CHECK(c.evaluate(1, 0) == 25);
+    CHECK(c.getPidStatus(0).output == 85.0);
+
+    CurveController swapped = make("pid:70 kp:50 ki:0 min:85 max:25 period:0");
+    CHECK(swapped.evaluate(0, 200) == 85);
+    CHECK(swapped.evaluate(1, 0) == 25);
+
+    // Out-of-range limits are clamped to 0-100
+    CurveController wide = make("pid:70 kp:50 ki:0 min:-10 max:150 period:0");
+    CHECK(wide.evaluate(0, 200) == 100);
+    CHECK(wide.evaluate(1, 0) == 0);
+}
+
+// The loop runs at most once per period; in between it holds its output
+static void testPeriod() {
+    CurveController c = make("pid:70 kp:5 ki:0 period:10");
+    unsigned int first = c.evaluate(0, 80);
+    CHECK(first == 50);
+    CHECK(c.evaluate(0, 90) == first);
+}
+
+// A reloaded curve continues the loop instead of starting from the minimum output
+static void testContinueFrom() {
+    const std::string loop = "pid:70 kp:5 ki:0.2 period:0";
+
+    // Fresh loop: integral at min, output is just the proportional term
+    CurveController fresh = make(loop);
+    CHECK(fresh.evaluate(0, 72) == 10);
+
+    // Replacing a curve: the first step reproduces the speed it last set (bumpless)
+    CurveController curve = make("50:30 80:90");
+    CurveController seeded = make(loop);
+    seeded.continueFrom(0, curve, 60);
+    CHECK(seeded.evaluate(0, 72) == 60);
+    CHECK(near(seeded.getPidStatus(0).integral, 50));
+
+    // Same target and gains: the state carries over as it was
+    CurveController same = make(loop);
+    same.continueFrom(0, seeded, 0);
+    CHECK(near(same.getPidStatus(0).integral, seeded.getPidStatus(0).integral));
+    CHECK(same.evaluate(0, 72) == 60);
+
+    // Changed target: starts from the previous loop's output, not from lastOutput
+    CurveController retargeted = make("pid:75 kp:5 ki:0.2 period:0");
+    retargeted.continueFrom(0, same, 0);
+    CHECK(retargeted.evaluate(0, 72) == 60);
+
+    // Slots are independent, and a started slot is left alone
+    CHECK(retargeted.evaluate(1, 77) == 10);
+    retargeted.continueFrom(0, curve, 95);
+    CHECK(retargeted.evaluate(0, 72) == 60);
+
+    // Curve mode has no state to continue
+    CurveController plain = make("50:30 80:90");
+    plain.continueFrom(0, same, 60);
+    CHECK(plain.evaluate(0, 50) == 30);
+}
+
+int main() {
+    testAntiWindup();
+    testOutputClamp();
+    testPeriod();
+    testContinueFrom();
+    return test::finish("CurveControllerPidTest");
+}
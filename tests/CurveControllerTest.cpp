@@ -0,0 +1,72 @@
+// Every fixed-point input of the compiled curve tables against the floating
+// point segment interpolation, over hand-picked edge cases and random curves.
+
+#include "Check.hpp"
+#include "CurveReference.hpp"
+#include "CurveController.hpp"
+#include <climits>
+#include <random>
+#include <string>
+
+using namespace temper;
+
+static const unsigned int FIXED_ONE = 1u << CurveController::FRACTION_BITS;
+
+// Returns the number of mismatches, reporting the first one
+static unsigned long checkCurve(const std::string& setpoints) {
+    CurveController curve;
+    curve.parseSetpoints(setpoints);
+    const auto& points = curve.getPoints();
+    unsigned int last = points.empty() ? 0 : points.back().temp;
+
+    unsigned long mismatches = 0;
+    auto compare = [&](unsigned int tempFixed) {
+        unsigned int expected = test::referenceInterpolate(points, (double)tempFixed / FIXED_ONE);
+        unsigned int actual = curve.interpolateFixed(tempFixed);
+        if (actual != expected && mismatches++ == 0) {
+            std::cerr << "\"" << setpoints << "\" at " << tempFixed << "/" << FIXED_ONE
+                      << ": " << actual << ", expected " << expected << std::endl;
+        }
+    };
+    // Every fixed-point step up to past the last setpoint, then the clamp at the top of the range
+    for (unsigned int t = 0; t <= (last + 2) * FIXED_ONE; ++t) compare(t);
+    compare(UINT_MAX - 1);
+    compare(UINT_MAX);
+
+    for (unsigned int t = 0; t <= last + 2; ++t) {
+        if (curve.interpolate(t) != test::referenceInterpolate(points, t)) mismatches++;
+    }
+    if (curve.interpolate(UINT_MAX) != test::referenceInterpolate(points, UINT_MAX >> CurveController::FRACTION_BITS)) mismatches++;
+    return mismatches;
+}
+
+int main() {
+    const char* edgeCases[] = {
+        "50:30 70:60 80:90",    // Default fan curve
+        "40:100 60:50 90:10",   // Decreasing: rounding down below zero offsets
+        "60:40",                // Single point
+        "50:30 60:40 60:80 70:90", // Step: two setpoints at one temperature
+        "50:30 50:60 70:90",    // Duplicate first temperature
+        "70:20 70:90",          // Every setpoint at one temperature
+        "0:0 3:100",            // Steep: several targets per degree
+        "0:0 100:1",            // Shallow
+        "30:4294967295 31:0",   // Extreme values
+        "0:0 5000:100",         // Too wide for a table: segment search
+        "",
+    };
+    for (const char* c : edgeCases) CHECK(checkCurve(c) == 0);
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<unsigned int> count(1, 8), temp(0, 120), value(0, 100);
+    unsigned long failedCurves = 0;
+    for (int n = 0; n < 2000; ++n) {
+        std::string setpoints;
+        for (unsigned int p = count(rng); p > 0; --p) {
+            setpoints += std::to_string(temp(rng)) + ":" + std::to_string(value(rng)) + " ";
+        }
+        if (checkCurve(setpoints) != 0) failedCurves++;
+    }
+    CHECK(failedCurves == 0);
+
+    return test::finish("CurveControllerTest");
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// The segment interpolation CurveController used before curves were compiled
+// into fixed-point tables, in floating point and taking fractional degrees.
+// The tables must reproduce it exactly.
+
+#include "Common.hpp"
+#include <vector>
+
+namespace temper {
+namespace test {
+
+inline unsigned int referenceInterpolate(const std::vector<CurvePoint>& points, double temp) {
+    if (points.empty()) return 0;
+    if (temp <= points.front().temp) return points.front().value;
+    if (temp >= points.back().temp) return points.back().value;
+
+    for (size_t i = 0; i < points.size() - 1; ++i) {
+        if (temp >= points[i].temp && temp <= points[i + 1].temp) {
+            double tempRange = points[i + 1].temp - points[i].temp;
+            double valRange = (double)points[i + 1].value - points[i].value;
+            double tempOffset = temp - points[i].temp;
+            return (unsigned int)(points[i].value + (valRange * tempOffset / tempRange));
+        }
+    }
+    return points.front().value;
+}
+
+} // namespace test
+} // namespace temper
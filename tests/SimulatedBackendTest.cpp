@@ -0,0 +1,87 @@
+// Drives SimulatedBackend the way the control loop does and checks the
+// model responds: fans cool, power limits cap, injected faults show up.
+
+#include "Check.hpp"
+#include "SimulatedBackend.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+using namespace temper;
+
+static void testParsePairs() {
+    auto pairs = SimulatedBackend::parsePairs("0:10 30:100 bad 5:x 1:2:3 7.5:8", "TEST");
+    CHECK(pairs.size() == 3);
+    if (pairs.size() == 3) {
+        CHECK(pairs[0].first == 0.0 && pairs[0].second == 10.0);
+        CHECK(pairs[1].first == 30.0 && pairs[1].second == 100.0);
+        CHECK(pairs[2].first == 7.5 && pairs[2].second == 8.0);
+    }
+    CHECK(SimulatedBackend::parsePairs("", "TEST").empty());
+}
+
+static void testClosedLoop() {
+    // 200 simulated seconds per wall second: half a second is five thermal time constants
+    setenv("SIM_WORKLOAD", "0:100", 1);
+    setenv("SIM_SPEED", "200", 1);
+    setenv("SIM_FAN_FAULT", "1:0 9:0 junk", 1);
+    SimulatedBackend sim(2);
+    CHECK(sim.getDeviceCount() == 2);
+    nvmlDevice_t gpu0 = sim.getHandle(0);
+    nvmlDevice_t gpu1 = sim.getHandle(1);
+
+    for (unsigned int fan = 0; fan < sim.getNumFans(gpu0); ++fan) {
+        sim.setFanSpeed(gpu0, fan, 100);
+        sim.setFanSpeed(gpu1, fan, 50);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    unsigned int util = 0, mem = 0;
+    sim.getUtilization(gpu0, util, mem);
+    CHECK(util == 100);
+    CHECK(sim.getTemperature(gpu0) < sim.getTemperature(gpu1));
+
+    // GPU 1 fan 0 is stuck: it reports the commanded speed but no RPM
+    auto fans = sim.getFans(gpu1);
+    CHECK(fans.size() == 2);
+    if (fans.size() == 2) {
+        CHECK((fans[0].valid & GpuBackend::FAN_RPM) && fans[0].rpm == 0 && fans[0].speed > 40);
+        CHECK(fans[1].rpm > 0);
+        CHECK(fans[1].policy == NVML_FAN_POLICY_MANUAL);
+    }
+    for (const auto& f : sim.getFans(gpu0)) CHECK(f.rpm > 0);
+
+    sim.setPowerLimit(gpu0, 150);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(sim.getPowerUsage(gpu0) <= 150000);
+    CHECK(sim.getThrottleReasons(gpu0) & nvmlClocksThrottleReasonSwPowerCap);
+
+    sim.restoreAutoFans(gpu1);
+    CHECK(sim.getFans(gpu1)[1].policy != NVML_FAN_POLICY_MANUAL);
+
+    bool threw = false;
+    try {
+        sim.setFanSpeed(gpu0, 0, 101);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void testIdle() {
+    setenv("SIM_WORKLOAD", "0:0", 1);
+    unsetenv("SIM_FAN_FAULT");
+    SimulatedBackend sim(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    nvmlDevice_t gpu = sim.getHandle(0);
+    CHECK(sim.getThrottleReasons(gpu) & nvmlClocksThrottleReasonGpuIdle);
+    CHECK(sim.getPowerState(gpu) == 8);
+}
+
+int main() {
+    testParsePairs();
+    testClosedLoop();
+    testIdle();
+    return test::finish("SimulatedBackendTest");
+}